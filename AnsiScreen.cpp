@@ -0,0 +1,148 @@
+#include "./AnsiScreen.h"
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+// ____________________________________________________________________________
+int AnsiScreen::paletteIndex(const Color &color) {
+  // Die Stufen des Farbwürfels (Indizes 16 bis 231) und die Graustufen
+  // 232 bis 255 (8, 18, ..., 238).
+  static const int LEVELS[6] = {0, 95, 135, 175, 215, 255};
+  int rgb[3] = {static_cast<int>(color.red() * 255 + 0.5f),
+                static_cast<int>(color.green() * 255 + 0.5f),
+                static_cast<int>(color.blue() * 255 + 0.5f)};
+  int cube = 0;
+  int cubeError = 0;
+  for (int value : rgb) {
+    int best = 0;
+    for (int i = 1; i < 6; i++) {
+      if (std::abs(LEVELS[i] - value) < std::abs(LEVELS[best] - value)) {
+        best = i;
+      }
+    }
+    cube = cube * 6 + best;
+    cubeError += (LEVELS[best] - value) * (LEVELS[best] - value);
+  }
+  int average = (rgb[0] + rgb[1] + rgb[2]) / 3;
+  int gray = average < 8 ? 0 : (average > 238 ? 23 : (average - 3) / 10);
+  int grayError = 0;
+  for (int value : rgb) {
+    grayError += (8 + 10 * gray - value) * (8 + 10 * gray - value);
+  }
+  return grayError < cubeError ? 232 + gray : 16 + cube;
+}
+
+// ____________________________________________________________________________
+AnsiScreen::AnsiScreen(const std::vector<std::pair<Color, Color>> &colors,
+                       int numRows, int numCharCols)
+    : numRows_(numRows), numCharCols_(numCharCols), fg_(-1), bg_(-1),
+      cells_(numRows * numCharCols), shown_(numRows * numCharCols) {
+  for (const auto &[fg, bg] : colors) {
+    colors_.emplace_back(paletteIndex(fg), paletteIndex(bg));
+  }
+  // Selbst wenn sich jedes Zeichen ändert, reicht das für das ganze Bild.
+  out_.reserve(cells_.size() * 32);
+}
+
+// ____________________________________________________________________________
+void AnsiScreen::invalidate() {
+  for (Cell &cell : shown_) {
+    cell.bg = UNKNOWN;
+  }
+  fg_ = UNKNOWN;
+  bg_ = UNKNOWN;
+}
+
+// ____________________________________________________________________________
+void AnsiScreen::checkColor(int color, const char *what) const {
+  if (color < 0 || color >= static_cast<int>(colors_.size())) {
+    throw std::runtime_error(std::string("Invalid color given to ") + what);
+  }
+}
+
+// ____________________________________________________________________________
+void AnsiScreen::put(int row, int charCol, char ch, int16_t fg, int16_t bg) {
+  if (row >= 0 && row < numRows_ && charCol >= 0 && charCol < numCharCols_) {
+    Cell &cell = cells_[row * numCharCols_ + charCol];
+    cell.ch = ch;
+    cell.fg = ch == ' ' ? ANY : fg;
+    cell.bg = bg;
+  }
+}
+
+// ____________________________________________________________________________
+void AnsiScreen::drawPixel(int row, int col, int color) {
+  checkColor(color, "drawPixel");
+  // Wie `A_REVERSE` bei ncurses: Ein Pixel ist ein Leerzeichen in der
+  // Vordergrundfarbe.
+  int16_t bg = colors_[color].first;
+  put(row, 2 * col, ' ', ANY, bg);
+  put(row, 2 * col + 1, ' ', ANY, bg);
+}
+
+// ____________________________________________________________________________
+void AnsiScreen::drawString(int row, int col, int color, const char *str) {
+  checkColor(color, "drawString");
+  auto [fg, bg] = colors_[color];
+  for (int i = 0; str[i] != '\0'; i++) {
+    put(row, 2 * col + i, str[i], fg, bg);
+  }
+}
+
+// ____________________________________________________________________________
+const std::string &AnsiScreen::compose() {
+  out_.clear();
+  // Wo der Cursor steht, -1 für unbekannt.
+  int cursorRow = -1;
+  int cursorCol = -1;
+  char sequence[32];
+  for (int row = 0; row < numRows_; row++) {
+    for (int col = 0; col < numCharCols_; col++) {
+      const Cell &cell = cells_[row * numCharCols_ + col];
+      Cell &shown = shown_[row * numCharCols_ + col];
+      if (cell == shown) {
+        continue;
+      }
+      if (row != cursorRow || col != cursorCol) {
+        int length = std::snprintf(sequence, sizeof(sequence), "\033[%d;%dH",
+                                   row + 1, col + 1);
+        out_.append(sequence, length);
+      }
+      // Nur die Farben setzen, die sich ändern, beide in einer Sequenz.
+      bool setFg = cell.fg != ANY && cell.fg != fg_;
+      bool setBg = cell.bg != bg_;
+      if (cell.bg < 0 && setBg) {
+        // Eine leere Zelle: zurück zu den Standardfarben.
+        out_ += "\033[0m";
+        fg_ = -1;
+        bg_ = -1;
+        setBg = false;
+      }
+      if (setFg || setBg) {
+        int length = 0;
+        if (setFg && setBg) {
+          length = std::snprintf(sequence, sizeof(sequence),
+                                 "\033[38;5;%d;48;5;%dm", cell.fg, cell.bg);
+        } else if (setFg) {
+          length = std::snprintf(sequence, sizeof(sequence), "\033[38;5;%dm",
+                                 cell.fg);
+        } else {
+          length = std::snprintf(sequence, sizeof(sequence), "\033[48;5;%dm",
+                                 cell.bg);
+        }
+        out_.append(sequence, length);
+        fg_ = setFg ? cell.fg : fg_;
+        bg_ = cell.bg;
+      }
+      out_ += cell.ch;
+      shown = cell;
+      cursorRow = row;
+      cursorCol = col + 1;
+      // Am rechten Rand hängt es vom Terminal ab, wo der Cursor danach steht.
+      if (cursorCol == numCharCols_) {
+        cursorRow = -1;
+      }
+    }
+  }
+  return out_;
+}
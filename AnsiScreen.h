@@ -0,0 +1,77 @@
+#pragma once
+
+#include "TerminalManager.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Der Bildschirm des ANSI-Backends von `TerminalManager`: Gezeichnet wird in
+// einen Zellenpuffer, `compose` erzeugt daraus die Escape-Sequenzen für alle
+// Zeichen, die sich seit dem letzten Aufruf geändert haben. Der Cursor wird
+// nur versetzt, wenn das nächste geänderte Zeichen nicht direkt folgt, die
+// Farbe nur gesetzt, wenn sie sich ändert. Der Ausgabepuffer behält seine
+// Größe, im eingeschwungenen Zustand wird also nichts mehr allokiert.
+//
+// Die Klasse kennt kein Terminal, sie lässt sich ohne eines testen; das
+// Schreiben übernimmt `TerminalManager`.
+class AnsiScreen {
+public:
+  // `colors` wie bei `TerminalManager`, `numCharCols` ist die Breite in
+  // Zeichen (ein Pixel ist zwei Zeichen breit). Jede Farbe wird durch die
+  // nächste der 256 Standardfarben ersetzt, deren Sequenzen viel kürzer sind
+  // als die für 24-Bit-Farben. Der Bildschirm muss zu Beginn leer sein.
+  AnsiScreen(const std::vector<std::pair<Color, Color>> &colors, int numRows,
+             int numCharCols);
+
+  int numRows() const { return numRows_; }
+  int numCharCols() const { return numCharCols_; }
+
+  // Wie bei `TerminalManager`. Was außerhalb des Bildschirms liegt, wird
+  // abgeschnitten.
+  void drawPixel(int row, int col, int color);
+  void drawString(int row, int col, int color, const char *str);
+
+  // Die Ausgabe für alle Änderungen seit dem letzten Aufruf (leer, wenn sich
+  // nichts geändert hat). Die Referenz ist bis zum nächsten Aufruf gültig.
+  const std::string &compose();
+
+  // Beim nächsten `compose` alles neu ausgeben (z.B. nach dem Löschen des
+  // Bildschirms).
+  void invalidate();
+
+  // Die nächste der 256 Standardfarben (Würfel 6x6x6 oder Graustufe).
+  static int paletteIndex(const Color &color);
+
+private:
+  static constexpr int16_t ANY = -2;
+  // Nicht bekannt, passt zu keiner Farbe.
+  static constexpr int16_t UNKNOWN = -3;
+
+  // Ein Zeichen mit Vorder- und Hintergrundfarbe (Index in die Palette, -1
+  // für die Standardfarbe des Terminals). Bei Leerzeichen spielt die
+  // Vordergrundfarbe keine Rolle und ist immer ANY.
+  struct Cell {
+    char ch = ' ';
+    int16_t fg = ANY;
+    int16_t bg = -1;
+    bool operator==(const Cell &other) const {
+      return ch == other.ch && fg == other.fg && bg == other.bg;
+    }
+  };
+
+  void put(int row, int charCol, char ch, int16_t fg, int16_t bg);
+  void checkColor(int color, const char *what) const;
+
+  int numRows_;
+  int numCharCols_;
+  // Die Farben, die am Terminal gerade gesetzt sind.
+  int16_t fg_;
+  int16_t bg_;
+  // Die Farbpaare aus dem Konstruktor als Paletten-Indizes.
+  std::vector<std::pair<int16_t, int16_t>> colors_;
+  // Was gezeichnet wurde und was das Terminal zeigt.
+  std::vector<Cell> cells_;
+  std::vector<Cell> shown_;
+  std::string out_;
+};
@@ -0,0 +1,226 @@
+#include "BatchEvaluator.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+void BatchFeatures::resize(int size) {
+  for (std::vector<uint16_t> *feature :
+       {&aggregateHeight, &holes, &bumpiness, &rowTransitions,
+        &columnTransitions, &wellCells, &linesCleared}) {
+    feature->resize(size);
+  }
+}
+
+BoardBatch::BoardBatch() : stride_(0), size_(0) {}
+
+void BoardBatch::reserve(int size) {
+  if (size <= stride_) {
+    return;
+  }
+  int stride = std::max(kLanes, stride_ * 2);
+  while (stride < size) {
+    stride *= 2;
+  }
+  std::vector<uint16_t> rows(Board::kHeight * stride, 0);
+  for (int r = 0; r < Board::kHeight && stride_ > 0; r++) {
+    std::memcpy(&rows[r * stride], &rows_[r * stride_],
+                size_ * sizeof(uint16_t));
+  }
+  rows_.swap(rows);
+  stride_ = stride;
+}
+
+void BoardBatch::add(const Board::Row *rows) {
+  reserve(size_ + 1);
+  for (int r = 0; r < Board::kHeight; r++) {
+    rows_[r * stride_ + size_] = rows[r];
+  }
+  size_++;
+}
+
+void BoardBatch::add(const Board &field, const Tetromino &placement) {
+  add(field.getRows().data());
+  const PieceRotation &shape = placement.getShape();
+  auto [row, col] = placement.getPosition();
+  for (int i = 0; i < shape.height; i++) {
+    rows_[(row + i) * stride_ + size_ - 1] |= shape.rows[i] << col;
+  }
+}
+
+namespace {
+constexpr uint16_t FULL = Board::kFullRow;
+constexpr int WELL_BITS = 5;
+static_assert(Board::kHeight < (1 << WELL_BITS), "Brunnen zu tief");
+
+// Der Kern, einmal für alle Varianten: `V` ist entweder ein einzelnes
+// `uint16_t` oder ein GCC-Vektor aus `uint16_t`. Alle Operationen sind
+// elementweise, der Code ist derselbe. Mit always_inline landet er in den
+// Funktionen mit `target`-Attribut und wird dort mit AVX2 bzw. SSE2 übersetzt.
+// Die Hilfsfunktionen nehmen Vektoren nur per Referenz, sonst warnt GCC vor
+// der Aufrufkonvention für AVX-Vektoren in Funktionen ohne AVX.
+template <class V> struct Lanes {
+  static constexpr int kCount = sizeof(V) / sizeof(uint16_t);
+
+  __attribute__((always_inline)) static void load(V &v, const uint16_t *p) {
+    std::memcpy(&v, p, sizeof(V));
+  }
+  __attribute__((always_inline)) static void store(uint16_t *p, const V &v) {
+    std::memcpy(p, &v, sizeof(V));
+  }
+
+  // 0xffff in den Elementen mit a == b, sonst 0.
+  __attribute__((always_inline)) static void equal(V &result, const V &a,
+                                                   uint16_t b) {
+    if constexpr (std::is_same_v<V, uint16_t>) {
+      result = a == b ? 0xffff : 0;
+    } else {
+      result = (V)(a == b);
+    }
+  }
+
+  // Ersetzt jedes Element durch die Anzahl seiner Bits (SWAR, ohne Tabelle).
+  __attribute__((always_inline)) static void popcount(V &v) {
+    v = v - ((v >> 1) & 0x5555);
+    v = (v & 0x3333) + ((v >> 2) & 0x3333);
+    v = (v + (v >> 4)) & 0x0f0f;
+    v = (v + (v >> 8)) & 0x1f;
+  }
+};
+
+template <class V>
+__attribute__((always_inline)) inline void
+evaluateLanes(const BoardBatch &batch, int first, BatchFeatures &out) {
+  using L = Lanes<V>;
+  V seen{}, previous{}, height{}, holes{}, bumpiness{}, rowTransitions{},
+      columnTransitions{}, wellCells{}, lines{};
+  V depthInWell[WELL_BITS] = {};
+  V x, full, keep, empty, count;
+  for (int r = 0; r < Board::kHeight; r++) {
+    L::load(x, batch.row(r) + first);
+    // Volle Zeilen werden übersprungen, als wären sie schon entfernt:
+    // `keep` ist 0xffff für alle anderen.
+    L::equal(full, x, FULL);
+    keep = ~full;
+    lines += full & 1;
+
+    count = seen & ~x;
+    L::popcount(count);
+    holes += keep & count;
+    seen |= x & keep;
+    count = seen;
+    L::popcount(count);
+    height += keep & count;
+    count = (seen ^ (seen >> 1)) & (FULL >> 1);
+    L::popcount(count);
+    bumpiness += keep & count;
+
+    // Leere Zeilen zählen nicht, wie bei `Board::Features`.
+    L::equal(empty, x, 0);
+    V walled = (x << 1) | 1 | (1 << (Board::kWidth + 1));
+    count = (walled ^ (walled >> 1)) & ((1 << (Board::kWidth + 1)) - 1);
+    L::popcount(count);
+    rowTransitions += keep & ~empty & count;
+    count = previous ^ x;
+    L::popcount(count);
+    columnTransitions += keep & count;
+    previous = (x & keep) | (previous & full);
+
+    // Tiefe im Brunnen pro Spalte, bitweise über WELL_BITS Ebenen gezählt:
+    // +1 für Brunnenzellen, 0 für alle anderen.
+    V well = ~x & ((x << 1) | 1) & ((x >> 1) | (1 << (Board::kWidth - 1))) &
+             FULL;
+    V carry = well;
+    V depthSum{};
+    for (int k = 0; k < WELL_BITS; k++) {
+      V next =
+          ((depthInWell[k] ^ carry) & well & keep) | (depthInWell[k] & full);
+      carry &= depthInWell[k];
+      depthInWell[k] = next;
+      L::popcount(next);
+      depthSum += next << k;
+    }
+    wellCells += keep & depthSum;
+  }
+  // Der Boden zählt als belegt.
+  count = previous ^ FULL;
+  L::popcount(count);
+  columnTransitions += count;
+
+  L::store(&out.aggregateHeight[first], height);
+  L::store(&out.holes[first], holes);
+  L::store(&out.bumpiness[first], bumpiness);
+  L::store(&out.rowTransitions[first], rowTransitions);
+  L::store(&out.columnTransitions[first], columnTransitions);
+  L::store(&out.wellCells[first], wellCells);
+  L::store(&out.linesCleared[first], lines);
+}
+
+void evaluateScalar(const BoardBatch &batch, BatchFeatures &out) {
+  for (int i = 0; i < batch.size(); i++) {
+    evaluateLanes<uint16_t>(batch, i, out);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+typedef uint16_t U16x8 __attribute__((vector_size(16)));
+typedef uint16_t U16x16 __attribute__((vector_size(32)));
+
+__attribute__((target("sse2"))) void evaluateSse2(const BoardBatch &batch,
+                                                  BatchFeatures &out) {
+  for (int i = 0; i < batch.size(); i += Lanes<U16x8>::kCount) {
+    evaluateLanes<U16x8>(batch, i, out);
+  }
+}
+
+__attribute__((target("avx2"))) void evaluateAvx2(const BoardBatch &batch,
+                                                  BatchFeatures &out) {
+  for (int i = 0; i < batch.size(); i += Lanes<U16x16>::kCount) {
+    evaluateLanes<U16x16>(batch, i, out);
+  }
+}
+#endif
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const SimdLevel level = __builtin_cpu_supports("avx2")
+                                     ? SimdLevel::Avx2
+                                     : (__builtin_cpu_supports("sse2")
+                                            ? SimdLevel::Sse2
+                                            : SimdLevel::Scalar);
+  return level;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return "scalar";
+  case SimdLevel::Sse2:
+    return "sse2";
+  case SimdLevel::Avx2:
+    return "avx2";
+  }
+  return "?";
+}
+
+void evaluateBatch(const BoardBatch &batch, BatchFeatures &features,
+                   SimdLevel level) {
+  // Die Vektorvarianten schreiben immer ganze Register, also bis zum Ende der
+  // aufgerundeten Zeilen.
+  features.resize(batch.stride());
+  switch (level) {
+#if defined(__x86_64__) || defined(__i386__)
+  case SimdLevel::Avx2:
+    evaluateAvx2(batch, features);
+    return;
+  case SimdLevel::Sse2:
+    evaluateSse2(batch, features);
+    return;
+#endif
+  default:
+    evaluateScalar(batch, features);
+  }
+}
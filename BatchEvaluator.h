@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Board.h"
+#include "Tetromino.h"
+#include <cstdint>
+#include <vector>
+
+// Bewertet viele Spielfelder auf einmal. Die Felder liegen spaltenweise
+// (Structure of Arrays): Zeile `r` aller Felder steht hintereinander, so dass
+// ein Vektorregister dieselbe Zeile von 8 (SSE2) bzw. 16 (AVX2) Feldern
+// enthält und alle Merkmale für diese Felder in einem Durchgang über die
+// Zeilen entstehen. Welche Variante läuft, wird zur Laufzeit entschieden.
+
+// Die Merkmale eines Feldes nach dem Entfernen voller Zeilen (die El-Tetris-
+// Merkmale von Pierre Dellacherie / Islam El-Ashi). Gleichnamige Merkmale
+// sind genau die von `Board::Features` bzw. `Board::featuresAfter`:
+//   aggregateHeight: Summe der Spaltenhöhen,
+//   holes: leere Zellen unter einer belegten Zelle derselben Spalte,
+//   bumpiness: Summe der Höhenunterschiede benachbarter Spalten,
+//   rowTransitions: Wechsel belegt/leer innerhalb der nicht leeren Zeilen,
+//     die Wände zählen als belegt,
+//   columnTransitions: Wechsel belegt/leer innerhalb der Spalten, der Boden
+//     zählt als belegt,
+//   wellCells: für jede Zelle eines Brunnens (leer, links und rechts belegt
+//     oder Wand) ihre Tiefe im Brunnen, also 1 + 2 + ... + d für einen
+//     Brunnen der Tiefe d. Anders als `Board::Features::wellDepth` zählen
+//     hier Zellen, auch verdeckte, nicht Höhenunterschiede,
+//   linesCleared: Anzahl der vollen Zeilen.
+struct BatchFeatures {
+  std::vector<uint16_t> aggregateHeight;
+  std::vector<uint16_t> holes;
+  std::vector<uint16_t> bumpiness;
+  std::vector<uint16_t> rowTransitions;
+  std::vector<uint16_t> columnTransitions;
+  std::vector<uint16_t> wellCells;
+  std::vector<uint16_t> linesCleared;
+
+  void resize(int size);
+};
+
+class BoardBatch {
+public:
+  // Die Anzahl der Felder wird intern auf ein Vielfaches davon aufgerundet.
+  static constexpr int kLanes = 16;
+
+  BoardBatch();
+
+  int size() const { return size_; }
+  void clear() { size_ = 0; }
+
+  // Hängt ein Feld an (Zeilenmasken, oberste Zeile zuerst).
+  void add(const Board::Row *rows);
+
+  // Hängt das Feld an, das entsteht, wenn `placement` in `field` festgesetzt
+  // wird (ohne volle Zeilen zu entfernen).
+  void add(const Board &field, const Tetromino &placement);
+
+  // Zeile `row` aller Felder, `stride()` Einträge.
+  const uint16_t *row(int row) const { return &rows_[row * stride_]; }
+  uint16_t *row(int row) { return &rows_[row * stride_]; }
+  int stride() const { return stride_; }
+
+private:
+  // Platz für mindestens `size` Felder.
+  void reserve(int size);
+
+  std::vector<uint16_t> rows_;
+  int stride_;
+  int size_;
+};
+
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+// Die beste Variante, die der Prozessor kann.
+SimdLevel detectSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+// Berechnet die Merkmale aller Felder in `batch`.
+void evaluateBatch(const BoardBatch &batch, BatchFeatures &features,
+                   SimdLevel level = detectSimdLevel());
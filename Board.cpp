@@ -0,0 +1,396 @@
+#include "Board.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+// Die Zufallswerte für den Zobrist-Hash, zur Compile-Zeit mit splitmix64
+// erzeugt, damit sie in jedem Lauf gleich sind.
+template <int W, int H> struct CellKeys {
+  uint64_t keys[H][W] = {};
+  constexpr CellKeys() {
+    uint64_t seed = 0x7a6f627269737421;
+    for (auto &row : keys) {
+      for (uint64_t &key : row) {
+        seed += 0x9e3779b97f4a7c15;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        key = z ^ (z >> 31);
+      }
+    }
+  }
+};
+template <int W, int H> constexpr CellKeys<W, H> CELL_KEYS;
+
+// Index des niedrigsten gesetzten Bits, für Zeilen jeder Breite.
+inline int lowestBit(uint64_t bits) { return __builtin_ctzll(bits); }
+
+template <int W, int H, class Row> uint64_t hashRow(int row, Row bits) {
+  uint64_t hash = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    hash ^= CELL_KEYS<W, H>.keys[row][lowestBit(bits)];
+  }
+  return hash;
+}
+
+// Anzahl der gesetzten Bits, für Zeilen jeder Breite.
+inline int countBits(uint64_t bits) { return __builtin_popcountll(bits); }
+
+// Wechsel zwischen belegt und leer in einer Zeile, die Wände zählen als
+// belegt. Leere Zeilen zählen nicht.
+template <int W, int H>
+int rowTransitions(typename BasicBoard<W, H>::Row bits) {
+  if (bits == 0) {
+    return 0;
+  }
+  return countBits((bits ^ (bits >> 1)) & (BasicBoard<W, H>::kFullRow >> 1)) +
+         !(bits & 1) + !((bits >> (W - 1)) & 1);
+}
+
+// Addiert (`sign` = 1) bzw. subtrahiert (-1) die Anteile der Spalten `first`
+// bis `last` an Bumpiness und Brunnentiefe: die Höhenunterschiede an ihren
+// Rändern und die Brunnen in ihnen und ihren Nachbarn, mit den Höhen
+// `height(col)`. Vorher abgezogen und nachher addiert ergibt das die
+// Änderung, wenn sich nur die Höhen dieser Spalten ändern.
+template <int W, int H, class Height>
+void addHeightTerms(Height height, int first, int last, int sign,
+                    typename BasicBoard<W, H>::Features &features) {
+  for (int c = std::max(first - 1, 0); c <= std::min(last, W - 2); c++) {
+    features.bumpiness += sign * std::abs(height(c) - height(c + 1));
+  }
+  for (int c = std::max(first - 1, 0); c <= std::min(last + 1, W - 1); c++) {
+    int left = c > 0 ? height(c - 1) : H;
+    int right = c < W - 1 ? height(c + 1) : H;
+    features.wellDepth += sign * std::max(0, std::min(left, right) - height(c));
+  }
+}
+} // namespace
+
+template <int W, int H> BasicBoard<W, H>::BasicBoard() {
+  rows_.fill(0);
+  heights_.fill(0);
+  hash_ = 0;
+  cells_ = 0;
+  for (auto &colorRow : colors_) {
+    colorRow.fill(0);
+  }
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::setCell(int row, int col, int color) {
+  if (isOccupied(row, col) != (color != 0)) {
+    hash_ ^= CELL_KEYS<W, H>.keys[row][col];
+    cells_ += color != 0 ? 1 : -1;
+  }
+  features_.rowTransitions -= rowTransitions<W, H>(rows_[row]);
+  if (color != 0) {
+    rows_[row] |= Row{1} << col;
+    if (heights_[col] < kHeight - row) {
+      auto height = [this](int c) { return heights_[c]; };
+      addHeightTerms<W, H>(height, col, col, -1, features_);
+      features_.aggregateHeight += kHeight - row - heights_[col];
+      heights_[col] = kHeight - row;
+      addHeightTerms<W, H>(height, col, col, 1, features_);
+    }
+  } else {
+    rows_[row] &= ~(Row{1} << col);
+    if (heights_[col] == kHeight - row) {
+      updateHeights();
+    }
+  }
+  features_.rowTransitions += rowTransitions<W, H>(rows_[row]);
+  features_.holes = features_.aggregateHeight - cells_;
+  colors_[row][col] = color;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::setRows(const Row *rows, int color) {
+  cells_ = 0;
+  features_.rowTransitions = 0;
+  for (int row = 0; row < kHeight; row++) {
+    rows_[row] = rows[row] & kFullRow;
+    for (int col = 0; col < kWidth; col++) {
+      colors_[row][col] = ((rows_[row] >> col) & 1) ? color : 0;
+    }
+    cells_ += countBits(rows_[row]);
+    features_.rowTransitions += rowTransitions<W, H>(rows_[row]);
+  }
+  updateHeights();
+  hash_ = hashRows(0, kHeight - 1);
+}
+
+template <int W, int H> void BasicBoard<W, H>::updateHeights(int firstRow) {
+  // Von oben nach unten, jede Spalte bekommt die Höhe ihrer ersten belegten
+  // Zeile.
+  heights_.fill(0);
+  Row seen = 0;
+  for (int row = firstRow; row < kHeight && seen != kFullRow; row++) {
+    for (Row bits = rows_[row] & ~seen; bits != 0; bits &= bits - 1) {
+      heights_[lowestBit(bits)] = kHeight - row;
+    }
+    seen |= rows_[row];
+  }
+  features_.aggregateHeight = 0;
+  for (int height : heights_) {
+    features_.aggregateHeight += height;
+  }
+  features_.bumpiness = 0;
+  features_.wellDepth = 0;
+  addHeightTerms<W, H>([this](int c) { return heights_[c]; }, 0, kWidth - 1, 1,
+                       features_);
+  features_.holes = features_.aggregateHeight - cells_;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::remember(Undo &undo, int first, int last) const {
+  if (undo.firstRow > undo.lastRow) {
+    undo.heights = heights_;
+    undo.features = features_;
+    undo.cells = cells_;
+    undo.hash = hash_;
+    undo.firstRow = first;
+    undo.lastRow = first - 1;
+  }
+  // Nur Zeilen, die noch nicht gesichert sind (die gesicherten können sich
+  // schon geändert haben), dazu die dazwischen, damit es ein Bereich bleibt.
+  for (int row = first; row < undo.firstRow; row++) {
+    undo.rows[row] = rows_[row];
+    undo.colors[row] = colors_[row];
+  }
+  for (int row = undo.lastRow + 1; row <= last; row++) {
+    undo.rows[row] = rows_[row];
+    undo.colors[row] = colors_[row];
+  }
+  undo.firstRow = std::min(undo.firstRow, first);
+  undo.lastRow = std::max(undo.lastRow, last);
+}
+
+template <int W, int H> void BasicBoard<W, H>::undo(Undo &undo) {
+  if (undo.firstRow > undo.lastRow) {
+    return;
+  }
+  for (int row = undo.firstRow; row <= undo.lastRow; row++) {
+    rows_[row] = undo.rows[row];
+    colors_[row] = undo.colors[row];
+  }
+  heights_ = undo.heights;
+  features_ = undo.features;
+  cells_ = undo.cells;
+  hash_ = undo.hash;
+  undo.firstRow = kHeight;
+  undo.lastRow = -1;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::fits(const PieceMask *masks, int height, int width,
+                            int row, int col) const {
+  if (row < 0 || col < 0 || row + height > kHeight || col + width > kWidth) {
+    return false;
+  }
+  for (int i = 0; i < height; i++) {
+    if (rows_[row + i] & (Row{masks[i]} << col)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::place(const PieceMask *masks, int height, int row,
+                             int col, int color, Undo *undo) {
+  if (undo != nullptr) {
+    remember(*undo, row, row + height - 1);
+  }
+  // Nur die Höhen der Spalten des Steins ändern sich.
+  PieceMask columns = 0;
+  for (int i = 0; i < height; i++) {
+    columns |= masks[i];
+  }
+  const int first = col + lowestBit(columns);
+  const int last = col + 31 - __builtin_clz(columns);
+  auto heightOf = [this](int c) { return heights_[c]; };
+  addHeightTerms<W, H>(heightOf, first, last, -1, features_);
+  for (int i = 0; i < height; i++) {
+    Row bits = Row{masks[i]} << col;
+    hash_ ^= hashRow<W, H>(row + i, bits & ~rows_[row + i]);
+    cells_ += countBits(bits & ~rows_[row + i]);
+    features_.rowTransitions -= rowTransitions<W, H>(rows_[row + i]);
+    rows_[row + i] |= bits;
+    features_.rowTransitions += rowTransitions<W, H>(rows_[row + i]);
+    for (Row rest = bits; rest != 0; rest &= rest - 1) {
+      int c = lowestBit(rest);
+      if (heights_[c] < kHeight - row - i) {
+        features_.aggregateHeight += kHeight - row - i - heights_[c];
+        heights_[c] = kHeight - row - i;
+      }
+      colors_[row + i][c] = color;
+    }
+  }
+  addHeightTerms<W, H>(heightOf, first, last, 1, features_);
+  features_.holes = features_.aggregateHeight - cells_;
+}
+
+template <int W, int H>
+typename BasicBoard<W, H>::Features
+BasicBoard<W, H>::featuresAfter(const PieceMask *masks, int height, int width,
+                                int row, int col, int *linesCleared) const {
+  Features features = features_;
+  int cells = cells_;
+  bool full = false;
+  for (int i = 0; i < height; i++) {
+    Row bits = rows_[row + i] | (Row{masks[i]} << col);
+    full |= bits == kFullRow;
+    features.rowTransitions += rowTransitions<W, H>(bits) -
+                               rowTransitions<W, H>(rows_[row + i]);
+    cells += countBits(masks[i]);
+  }
+  if (full) {
+    // Entfernte Zeilen verschieben alles darüber, das ist der seltene Fall.
+    BasicBoard after = *this;
+    after.place(masks, height, row, col, 1);
+    int lines = after.clearFullLines();
+    if (linesCleared != nullptr) {
+      *linesCleared = lines;
+    }
+    return after.features_;
+  }
+  if (linesCleared != nullptr) {
+    *linesCleared = 0;
+  }
+
+  // Die neuen Höhen der Spalten des Steins, von oben nach unten.
+  int pieceHeights[4];
+  for (int j = 0; j < width; j++) {
+    pieceHeights[j] = heights_[col + j];
+  }
+  for (int i = height - 1; i >= 0; i--) {
+    for (PieceMask bits = masks[i]; bits != 0; bits &= bits - 1) {
+      pieceHeights[lowestBit(bits)] = kHeight - row - i;
+    }
+  }
+  auto before = [this](int c) { return heights_[c]; };
+  auto after = [&](int c) {
+    return c >= col && c < col + width
+               ? std::max<int>(heights_[c], pieceHeights[c - col])
+               : heights_[c];
+  };
+  addHeightTerms<W, H>(before, col, col + width - 1, -1, features);
+  addHeightTerms<W, H>(after, col, col + width - 1, 1, features);
+  for (int j = 0; j < width; j++) {
+    features.aggregateHeight += after(col + j) - heights_[col + j];
+  }
+  features.holes = features.aggregateHeight - cells;
+  return features;
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::landingRow(const PieceMask *masks,
+                                 const uint8_t *bottoms, int height, int width,
+                                 int row, int col) const {
+  int landing = kHeight - height;
+  for (int j = 0; j < width; j++) {
+    landing = std::min(landing, kHeight - heights_[col + j] - 1 - bottoms[j]);
+  }
+  if (landing >= row) {
+    return landing;
+  }
+  // Unter einem Überhang: die Höhen sagen nichts über die Lücke darunter.
+  while (fits(masks, height, width, row + 1, col)) {
+    row++;
+  }
+  return row;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::addGarbage(int count, int holeCol, int color) {
+  count = std::min(count, kHeight);
+  bool overflow = false;
+  for (int row = 0; row < count; row++) {
+    overflow |= rows_[row] != 0;
+  }
+  for (int row = 0; row + count < kHeight; row++) {
+    rows_[row] = rows_[row + count];
+    colors_[row] = colors_[row + count];
+  }
+  for (int row = kHeight - count; row < kHeight; row++) {
+    rows_[row] = kFullRow & ~(Row{1} << holeCol);
+    colors_[row].fill(color);
+    colors_[row][holeCol] = 0;
+  }
+  cells_ = 0;
+  features_.rowTransitions = 0;
+  for (Row bits : rows_) {
+    cells_ += countBits(bits);
+    features_.rowTransitions += rowTransitions<W, H>(bits);
+  }
+  updateHeights();
+  hash_ = hashRows(0, kHeight - 1);
+  return !overflow;
+}
+
+template <int W, int H>
+uint64_t BasicBoard<W, H>::hashRows(int firstRow, int lastRow) const {
+  uint64_t hash = 0;
+  for (int row = firstRow; row <= lastRow; row++) {
+    hash ^= hashRow<W, H>(row, rows_[row]);
+  }
+  return hash;
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::clearFullLines(RowMask *cleared, Undo *undo) {
+  if (cleared != nullptr) {
+    cleared->reset();
+  }
+  // Nur die Zeilen von der obersten belegten bis zur untersten vollen Zeile
+  // ändern sich, nur deren Anteil am Hash wird neu berechnet. Darüber ist
+  // alles leer und bleibt es, die Kosten hängen also von der Höhe des
+  // Stapels ab, nicht von der des Feldes.
+  int lowestFull = kHeight - 1;
+  while (lowestFull >= 0 && rows_[lowestFull] != kFullRow) {
+    lowestFull--;
+  }
+  if (lowestFull < 0) {
+    return 0;
+  }
+  const int top = kHeight - *std::max_element(heights_.begin(), heights_.end());
+  if (undo != nullptr) {
+    remember(*undo, top, lowestFull);
+  }
+  hash_ ^= hashRows(top, lowestFull);
+
+  // Von unten nach oben: jede nicht volle Zeile wird genau einmal an ihre
+  // neue Position kopiert.
+  int count = 0;
+  int target = kHeight - 1;
+  for (int row = kHeight - 1; row >= top; row--) {
+    if (rows_[row] == kFullRow) {
+      if (cleared != nullptr) {
+        cleared->set(row);
+      }
+      count++;
+      continue;
+    }
+    if (target != row) {
+      rows_[target] = rows_[row];
+      colors_[target] = colors_[row];
+    }
+    target--;
+  }
+  for (int row = top; row <= target; row++) {
+    rows_[row] = 0;
+    colors_[row].fill(0);
+  }
+  // Volle Zeilen haben keine Wechsel, `rowTransitions` bleibt also gleich.
+  // Jede Spalte verliert genau `count` Zellen, ihre Höhe aber mehr, wenn
+  // darunter Löcher frei werden.
+  cells_ -= count * kWidth;
+  updateHeights(top + count);
+  hash_ ^= hashRows(top, lowestFull);
+  return count;
+}
+
+template class BasicBoard<10, 20>;
+template class BasicBoard<16, 40>;
+template class BasicBoard<32, 32>;
+template class BasicBoard<64, 64>;
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <type_traits>
+
+// Eine Zeile eines Tetrominos als Bitmaske (höchstens 4 Spalten breit),
+// unabhängig von der Breite des Feldes.
+using PieceMask = uint16_t;
+
+// Spielfeld als Bitboard: Die Belegung wird pro Zeile in einem Maschinenwort
+// gespeichert (Bit `c` gehört zu Spalte `c`), die Farben separat. Damit ist ein
+// Kollisionstest ein paar AND-Operationen pro Zeile des Tetrominos und der Test
+// auf eine volle Zeile ein einziger Vergleich.
+//
+// Breite und Höhe sind Template-Parameter: Das Maschinenwort ist das kleinste,
+// in das eine Zeile passt (16, 32 oder 64 Bit), und alle Schleifen über
+// Zeilen und Spalten haben feste Grenzen. Das Spiel benutzt `Board` (10x20),
+// die anderen Größen unten sind für Stresstests und Regelvarianten, z.B.
+// `SelfPlayMain --board 64x64`. Die Implementierung steht in Board.cpp und
+// wird dort für genau diese Größen instanziiert.
+template <int W, int H> class BasicBoard {
+  static_assert(W >= 4 && W <= 64, "Breite von 4 bis 64 Spalten");
+  static_assert(H >= 4 && H <= 255, "Höhe von 4 bis 255 Zeilen");
+
+public:
+  static constexpr int kWidth = W;
+  static constexpr int kHeight = H;
+  using Row = std::conditional_t<
+      (W <= 16), uint16_t, std::conditional_t<(W <= 32), uint32_t, uint64_t>>;
+  static constexpr Row kFullRow =
+      W == 64 ? ~Row{0} : static_cast<Row>((uint64_t{1} << W) - 1);
+  // Ein Bit pro Zeile, z.B. für die entfernten Zeilen.
+  using RowMask = std::bitset<H>;
+
+  // Merkmale der Oberfläche für die Bewertung einer Stellung. Sie werden wie
+  // die Spaltenhöhen bei jeder Änderung mitgeführt, beim Setzen eines Steins
+  // nur für seine Zeilen und Spalten (und deren Nachbarn).
+  struct Features {
+    // Summe der Spaltenhöhen.
+    int aggregateHeight = 0;
+    // Leere Zellen unter der Oberfläche.
+    int holes = 0;
+    // Summe der Höhenunterschiede benachbarter Spalten.
+    int bumpiness = 0;
+    // Wechsel zwischen belegt und leer innerhalb der nicht leeren Zeilen, die
+    // Wände zählen als belegt.
+    int rowTransitions = 0;
+    // Summe der Tiefen aller Brunnen: wie weit eine Spalte unter der
+    // niedrigeren ihrer Nachbarn liegt (die Wände sind so hoch wie das Feld).
+    int wellDepth = 0;
+  };
+
+  // Was `place` und `clearFullLines` ändern, damit `undo` den Zustand davor
+  // wiederherstellen kann, ohne das ganze Feld zu kopieren: Gesichert werden
+  // nur die Zeilen, die sich ändern, und die mitgeführten Werte. Ein `Undo`
+  // kann über mehrere Änderungen hinweg gesammelt und nach `undo` wieder
+  // benutzt werden.
+  struct Undo {
+    // Die gesicherten Zeilen (leer, wenn `firstRow > lastRow`).
+    int firstRow = kHeight;
+    int lastRow = -1;
+    std::array<Row, kHeight> rows;
+    std::array<std::array<uint8_t, kWidth>, kHeight> colors;
+    std::array<uint8_t, kWidth> heights;
+    Features features;
+    int cells;
+    uint64_t hash;
+  };
+
+  // Leeres Spielfeld.
+  BasicBoard();
+
+  int width() const { return kWidth; }
+  int height() const { return kHeight; }
+
+  // Belegung und Farbe einer Zelle (Farbe 0 heißt leer).
+  bool isOccupied(int row, int col) const { return (rows_[row] >> col) & 1; }
+  int getColor(int row, int col) const { return colors_[row][col]; }
+
+  // Belegung einer ganzen Zeile als Bitmaske.
+  Row getRow(int row) const { return rows_[row]; }
+
+  // Höhe der Oberfläche in Spalte `col`: Anzahl der Zeilen von unten bis
+  // einschließlich der obersten belegten Zelle (0 für eine leere Spalte). Wird
+  // bei jeder Änderung mitgeführt.
+  int columnHeight(int col) const { return heights_[col]; }
+
+  // Zobrist-Hash der Belegung (nicht der Farben): XOR eines festen
+  // Zufallswerts pro belegter Zelle. Wird bei jeder Änderung mitgeführt,
+  // gleiche Belegung heißt also gleicher Hash, egal wie sie entstanden ist.
+  uint64_t hash() const { return hash_; }
+
+  // Die mitgeführten Merkmale (siehe `Features`).
+  const Features &features() const { return features_; }
+
+  // Die Merkmale nach dem Setzen eines Steins (siehe `fits`) und dem
+  // Entfernen voller Zeilen, ohne das Feld zu ändern. Das Feld selbst darf
+  // keine vollen Zeilen haben. Füllt der Stein keine Zeile, werden
+  // nur die Zeilen und Spalten des Steins betrachtet, die Kosten hängen
+  // also nicht von der Größe des Feldes ab. Die Anzahl der entfernten
+  // Zeilen steht danach, falls gegeben, in `linesCleared`.
+  Features featuresAfter(const PieceMask *masks, int height, int width,
+                         int row, int col, int *linesCleared = nullptr) const;
+
+  // Belegung aller Zeilen, oberste Zeile zuerst.
+  const std::array<Row, kHeight> &getRows() const { return rows_; }
+
+  // Setzt eine einzelne Zelle, Farbe 0 leert sie.
+  void setCell(int row, int col, int color);
+
+  // Setzt die Belegung aller Zeilen auf einmal (oberste Zeile zuerst, z.B.
+  // aus `getRows`), belegte Zellen bekommen die Farbe `color`. Volle Zeilen
+  // bleiben stehen.
+  void setRows(const Row *rows, int color);
+
+  // Prüft, ob ein Stein mit den Zeilenmasken `masks` (`height` Zeilen, `width`
+  // Spalten breit) mit seiner linken oberen Ecke an (row, col) ins Feld passt.
+  bool fits(const PieceMask *masks, int height, int width, int row,
+            int col) const;
+
+  // Setzt den Stein (siehe `fits`) in der gegebenen Farbe ins Feld. Die
+  // Position muss gültig sein. Mit `undo` kann das später zurückgenommen
+  // werden.
+  void place(const PieceMask *masks, int height, int row, int col, int color,
+             Undo *undo = nullptr);
+
+  // Die Zeile, in der ein Stein (siehe `fits`) landet, wenn er von (row, col)
+  // aus gerade nach unten fällt. `bottoms[j]` ist die unterste belegte Zeile
+  // des Steins in seiner Spalte `j`. Liegt der Stein über der Oberfläche,
+  // folgt das Ergebnis direkt aus den Spaltenhöhen, nur unter einem Überhang
+  // wird Zeile für Zeile geprüft. Die Position (row, col) muss gültig sein.
+  int landingRow(const PieceMask *masks, const uint8_t *bottoms, int height,
+                 int width, int row, int col) const;
+
+  // Schiebt das Feld um `count` Zeilen nach oben und füllt unten mit Müll-
+  // zeilen in der Farbe `color` auf, die alle bis auf die Spalte `holeCol`
+  // voll sind. Gibt false zurück, wenn dabei belegte Zellen oben aus dem Feld
+  // geschoben wurden.
+  bool addGarbage(int count, int holeCol, int color);
+
+  // Entfernt alle vollen Zeilen in einem Durchgang, die Zeilen darüber
+  // rutschen nach unten. Gibt die Anzahl der entfernten Zeilen zurück und
+  // markiert sie, falls gegeben, in `cleared` (Zeilennummern von vorher).
+  int clearFullLines(RowMask *cleared = nullptr, Undo *undo = nullptr);
+
+  // Stellt den Zustand vor allen in `undo` gesammelten Änderungen wieder her
+  // und leert `undo`.
+  void undo(Undo &undo);
+
+private:
+  // Berechnet alle Spaltenhöhen neu aus den Zeilen ab `firstRow` (darüber
+  // ist alles leer), dazu alle Merkmale, die nur von ihnen abhängen.
+  void updateHeights(int firstRow = 0);
+
+  // Sichert die Zeilen `first` bis `last` in `undo`, soweit noch nicht
+  // geschehen, beim ersten Mal auch die mitgeführten Werte.
+  void remember(Undo &undo, int first, int last) const;
+
+  // Der Anteil der Zeilen `firstRow` bis `lastRow` am Zobrist-Hash.
+  uint64_t hashRows(int firstRow, int lastRow) const;
+
+  std::array<Row, kHeight> rows_;
+  std::array<uint8_t, kWidth> heights_;
+  uint64_t hash_;
+  Features features_;
+  // Anzahl der belegten Zellen (für `Features::holes`).
+  int cells_;
+  std::array<std::array<uint8_t, kWidth>, kHeight> colors_;
+};
+
+// Das Feld des Spiels.
+using Board = BasicBoard<10, 20>;
+
+// Größere Felder, alle in Board.cpp instanziiert.
+using TallBoard = BasicBoard<16, 40>;
+using WideBoard = BasicBoard<32, 32>;
+using HugeBoard = BasicBoard<64, 64>;
@@ -0,0 +1,207 @@
+#include "Bot.h"
+#include <algorithm>
+#include <limits>
+
+BoardFeatures computeFeatures(const Board::Row *rows) {
+  // `seen` hat ein Bit für jede Spalte, deren oberster Block bei oder über der
+  // aktuellen Zeile liegt. So ergeben sich alle Merkmale aus einem Durchgang
+  // über die Zeilen.
+  const Board::Row bumpMask = Board::kFullRow >> 1;
+  BoardFeatures features;
+  Board::Row seen = 0;
+  for (int row = 0; row < Board::kHeight; row++) {
+    if (rows[row] == Board::kFullRow) {
+      features.linesCleared++;
+      continue;
+    }
+    features.holes += __builtin_popcount(seen & ~rows[row]);
+    seen |= rows[row];
+    features.aggregateHeight += __builtin_popcount(seen);
+    features.bumpiness += __builtin_popcount((seen ^ (seen >> 1)) & bumpMask);
+  }
+  return features;
+}
+
+namespace {
+// Wert einer Folge, nach der ein Stein nicht mehr ins Feld passt.
+const float LOST = -1e9f;
+} // namespace
+
+Bot::Bot(const BotWeights &weights, int lookahead, TranspositionTable *table)
+    : weights_(weights), lookahead_(lookahead), table_(table),
+      generators_(lookahead + 1), target_(PIECE_I) {}
+
+template <class B>
+double evaluatePlacement(const BotWeights &weights, const B &field,
+                         const Tetromino &placement) {
+  const PieceRotation &shape = placement.getShape();
+  auto [row, col] = placement.getPosition();
+  int lines;
+  typename B::Features features = field.featuresAfter(
+      shape.rows, shape.height, shape.width, row, col, &lines);
+  return weights.aggregateHeight * features.aggregateHeight +
+         weights.holes * features.holes +
+         weights.bumpiness * features.bumpiness +
+         weights.linesCleared * lines;
+}
+
+template double evaluatePlacement(const BotWeights &, const Board &,
+                                  const Tetromino &);
+template double evaluatePlacement(const BotWeights &, const TallBoard &,
+                                  const Tetromino &);
+template double evaluatePlacement(const BotWeights &, const WideBoard &,
+                                  const Tetromino &);
+template double evaluatePlacement(const BotWeights &, const HugeBoard &,
+                                  const Tetromino &);
+
+double Bot::evaluate(const Board &field, const Tetromino &placement) const {
+  return evaluatePlacement(weights_, field, placement);
+}
+
+void Bot::evaluateAll(const Board &field,
+                      const std::vector<Tetromino> &placements) {
+  batch_.clear();
+  for (const Tetromino &placement : placements) {
+    batch_.add(field, placement);
+  }
+  evaluateBatch(batch_, features_);
+}
+
+double Bot::batchScore(int i) const {
+  return weights_.aggregateHeight * features_.aggregateHeight[i] +
+         weights_.holes * features_.holes[i] +
+         weights_.bumpiness * features_.bumpiness[i] +
+         weights_.linesCleared * features_.linesCleared[i];
+}
+
+bool Bot::choosePlacement(const GameState &state, Tetromino &best) {
+  const std::vector<Tetromino> &placements =
+      generators_[0].generate(state.field, state.currentTetromino);
+  placementsEvaluated_ += placements.size();
+  // Die bekannten nächsten Steine für die Vorausschau.
+  int pieces[Tetrominos::kMaxPreview + 1];
+  int count = 0;
+  if (lookahead_ > 0) {
+    pieces[count++] = state.nextTetromino.getPiece();
+    for (int i = 0; i < state.tetrominos.previewSize() && count < lookahead_;
+         i++) {
+      pieces[count++] = state.tetrominos.peek(i);
+    }
+  }
+  if (count == 0) {
+    evaluateAll(state.field, placements);
+  }
+  double bestScore = -std::numeric_limits<double>::infinity();
+  Board field = state.field;
+  Board::Undo undo;
+  for (size_t i = 0; i < placements.size(); i++) {
+    const Tetromino &placement = placements[i];
+    double score;
+    if (count == 0) {
+      score = batchScore(i);
+    } else {
+      placeTetrominoInField(field, placement, &undo);
+      int lines = field.clearFullLines(nullptr, &undo);
+      score = weights_.linesCleared * lines +
+              searchValue(field, pieces, count, 1);
+      field.undo(undo);
+    }
+    if (score > bestScore) {
+      bestScore = score;
+      best = placement;
+    }
+  }
+  return !placements.empty();
+}
+
+float Bot::searchValue(Board &field, const int *pieces, int count, int depth) {
+  if (count == 0) {
+    const Board::Features &features = field.features();
+    return weights_.aggregateHeight * features.aggregateHeight +
+           weights_.holes * features.holes +
+           weights_.bumpiness * features.bumpiness;
+  }
+  uint64_t key = field.hash();
+  for (int i = 0; i < count; i++) {
+    key ^= TranspositionTable::pieceKey(i, pieces[i]);
+  }
+  float value;
+  if (table_ != nullptr && table_->probe(key, value)) {
+    tableHits_++;
+    return value;
+  }
+
+  const std::vector<Tetromino> &placements =
+      generators_[depth].generate(field, Tetromino(pieces[0]));
+  placementsEvaluated_ += placements.size();
+  value = LOST;
+  if (count == 1) {
+    // Auf der letzten Ebene werden alle Endpositionen zusammen bewertet.
+    evaluateAll(field, placements);
+    for (size_t i = 0; i < placements.size(); i++) {
+      value = std::max<float>(value, batchScore(i));
+    }
+  } else {
+    Board::Undo undo;
+    for (const Tetromino &placement : placements) {
+      placeTetrominoInField(field, placement, &undo);
+      int lines = field.clearFullLines(nullptr, &undo);
+      value = std::max<float>(value,
+                              weights_.linesCleared * lines +
+                                  searchValue(field, pieces + 1, count - 1,
+                                              depth + 1));
+      field.undo(undo);
+    }
+  }
+  if (table_ != nullptr) {
+    table_->store(key, value);
+  }
+  return value;
+}
+
+const std::vector<Action> &Bot::planMoves(const GameState &state) {
+  // `choosePlacement` sucht vom aktuellen Stein aus, ohne Endposition ist der
+  // Weg leer.
+  Tetromino best = state.currentTetromino;
+  choosePlacement(state, best);
+  return generators_[0].pathTo(best);
+}
+
+Action Bot::nextAction(const GameState &state) {
+  if (state.gameOver) {
+    return Action::None;
+  }
+  if (plannedFor_ != state.piecesPlaced) {
+    if (!choosePlacement(state, target_)) {
+      return Action::None;
+    }
+    plannedFor_ = state.piecesPlaced;
+  }
+  generators_[0].generate(state.field, state.currentTetromino);
+  const std::vector<Action> *path = &generators_[0].pathTo(target_);
+  if (path->empty()) {
+    // Das Ziel ist nicht mehr erreichbar, also neu wählen.
+    choosePlacement(state, target_);
+    path = &generators_[0].pathTo(target_);
+  }
+  return path->empty() ? Action::None : path->front();
+}
+
+bool Bot::playPiece(GameState &state) {
+  const std::vector<Action> &path = planMoves(state);
+  if (path.empty()) {
+    return false;
+  }
+  for (Action action : path) {
+    applyAction(state, action);
+  }
+  return true;
+}
+
+void playGame(GameState &state, Bot &bot, int maxPieces) {
+  while (!state.gameOver && state.piecesPlaced < maxPieces) {
+    if (!bot.playPiece(state)) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BatchEvaluator.h"
+#include "Board.h"
+#include "Game.h"
+#include "Placement.h"
+#include "Tetromino.h"
+#include "TranspositionTable.h"
+#include <cstdint>
+#include <vector>
+
+// Merkmale eines Spielfelds, nach denen der Bot eine Endposition bewertet.
+struct BoardFeatures {
+  int aggregateHeight = 0;
+  int holes = 0;
+  int bumpiness = 0;
+  int linesCleared = 0;
+};
+
+// Berechnet die Merkmale für die Zeilenmasken `rows` (oberste Zeile zuerst).
+// Volle Zeilen zählen als entfernte Zeilen, die übrigen Merkmale beziehen sich
+// auf das Feld nach dem Entfernen.
+BoardFeatures computeFeatures(const Board::Row *rows);
+
+// Gewichte der Merkmale (positiv ist gut).
+struct BotWeights {
+  double aggregateHeight = -0.510066;
+  double holes = -0.35663;
+  double bumpiness = -0.184483;
+  double linesCleared = 0.760666;
+};
+
+// Der Wert, den der Bot ohne Vorausschau dem Feld gibt, das entsteht, wenn
+// `placement` festgesetzt wird, für alle Größen aus Board.h (siehe Bot.cpp).
+template <class B>
+double evaluatePlacement(const BotWeights &weights, const B &field,
+                         const Tetromino &placement);
+
+// Ein einfacher Bot: bewertet alle erreichbaren Endpositionen des aktuellen
+// Steins und spielt die beste über dieselben Eingaben wie ein Mensch.
+//
+// Mit `lookahead` > 0 schaut er so viele der bekannten nächsten Steine voraus
+// (höchstens der nächste Stein plus die Vorschau) und nimmt die Endposition,
+// nach der die beste Folge von Endpositionen möglich ist. Verschiedene Wege
+// führen oft zum selben Feld, auch über aufeinanderfolgende Steine hinweg.
+// Mit einer `table` wird jedes (Feld, kommende Steine) nur einmal bewertet.
+// Die Tabelle kann von mehreren Bots in mehreren Threads geteilt werden.
+class Bot {
+public:
+  explicit Bot(const BotWeights &weights = BotWeights(), int lookahead = 0,
+               TranspositionTable *table = nullptr);
+
+  // Bewertet das Feld, das entsteht, wenn `placement` festgesetzt wird.
+  double evaluate(const Board &field, const Tetromino &placement) const;
+
+  // Sucht die beste Endposition für den aktuellen Stein. Gibt false zurück,
+  // wenn es keine gibt.
+  bool choosePlacement(const GameState &state, Tetromino &best);
+
+  // Die Eingaben vom aktuellen Stein zur besten Endposition, inklusive des
+  // Hard Drops, der ihn festsetzt. Die Referenz ist bis zum nächsten Aufruf
+  // gültig.
+  const std::vector<Action> &planMoves(const GameState &state);
+
+  // Die nächste Eingabe im Echtzeitbetrieb (`--autoplay`): Das Ziel wird einmal
+  // pro Stein gewählt, der Weg dorthin in jedem Frame neu gesucht, damit die
+  // Schwerkraft den Plan nicht kaputt macht.
+  Action nextAction(const GameState &state);
+
+  // Spielt den aktuellen Stein sofort über `applyAction`. Gibt false zurück,
+  // wenn es keine Endposition gab.
+  bool playPiece(GameState &state);
+
+  // Anzahl der bisher bewerteten Endpositionen (in der Vorausschau: der
+  // besuchten Knoten).
+  int64_t placementsEvaluated() const { return placementsEvaluated_; }
+
+  // Anzahl der Stellungen der Vorausschau, deren Wert in der Tabelle stand.
+  int64_t tableHits() const { return tableHits_; }
+
+private:
+  // Wert des Feldes `field` (ohne volle Zeilen), wenn danach noch die `count`
+  // Steine `pieces` kommen. `depth` wählt den Generator. Die Steine werden
+  // in `field` selbst gesetzt und wieder zurückgenommen, danach ist es
+  // unverändert.
+  float searchValue(Board &field, const int *pieces, int count, int depth);
+
+  // Bewertet alle `placements` in `field` auf einmal mit `evaluateBatch`, der
+  // Wert der Endposition `i` ist danach `batchScore(i)` (wie `evaluate`).
+  void evaluateAll(const Board &field,
+                   const std::vector<Tetromino> &placements);
+  double batchScore(int i) const;
+
+  BotWeights weights_;
+  int lookahead_;
+  TranspositionTable *table_;
+  // Ein Generator pro Tiefe der Vorausschau, `generators_[0]` für den
+  // aktuellen Stein.
+  std::vector<PlacementGenerator> generators_;
+  BoardBatch batch_;
+  BatchFeatures features_;
+  int64_t placementsEvaluated_ = 0;
+  int64_t tableHits_ = 0;
+  // Für `nextAction`: das Ziel für den Stein Nummer `plannedFor_`.
+  int plannedFor_ = -1;
+  Tetromino target_;
+};
+
+// Spielt ein Spiel ohne Terminal, bis es vorbei ist oder `maxPieces` Steine
+// gesetzt wurden.
+void playGame(GameState &state, Bot &bot, int maxPieces);
@@ -0,0 +1,214 @@
+#include "Corpus.h"
+#include "Bot.h"
+#include "Game.h"
+#include "Placement.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+static const char CORPUS_MAGIC[4] = {'T', 'T', 'R', 'C'};
+
+namespace {
+CorpusHeader makeHeader(const CorpusOptions &options, size_t numRecords) {
+  CorpusHeader header = {};
+  std::memcpy(header.magic, CORPUS_MAGIC, 4);
+  header.version = CORPUS_VERSION;
+  header.width = Board::kWidth;
+  header.height = Board::kHeight;
+  header.recordSize = sizeof(CorpusRecord);
+  header.numRecords = numRecords;
+  header.firstSeed = options.firstSeed;
+  header.maxPieces = options.maxPieces;
+  header.skipPieces = options.skipPieces;
+  header.interval = options.interval;
+  header.randomizer = static_cast<uint8_t>(options.randomizer);
+  header.randomPercent = options.randomPercent;
+  return header;
+}
+
+CorpusRecord makeRecord(const GameState &state, uint64_t seed) {
+  CorpusRecord record = {};
+  const auto &rows = state.field.getRows();
+  std::copy(rows.begin(), rows.end(), record.rows);
+  const Tetromino &tetromino = state.currentTetromino;
+  record.piece = tetromino.getPiece();
+  record.rotation = tetromino.getRotation();
+  record.row = tetromino.getPosition().first;
+  record.col = tetromino.getPosition().second;
+  record.nextPiece = state.nextTetromino.getPiece();
+  record.seed = seed;
+  record.piecesPlaced = state.piecesPlaced;
+  record.linesCleared = state.totalLinesCleared;
+  return record;
+}
+
+// Spielt das Spiel mit dem Seed `seed` und hängt seine Stellungen an
+// `records` an. Von jedem aufgenommenen Stein wird eine zufällige Position
+// auf seinem Weg genommen, vom Startpunkt bis kurz vor dem Hard Drop.
+void playCorpusGame(const CorpusOptions &options, uint64_t seed,
+                    std::vector<CorpusRecord> &records) {
+  Bot bot;
+  PlacementGenerator generator;
+  // Die Steine zieht `Tetrominos` aus `Random(seed)`. Mit demselben Seed
+  // liefe dieser Strom fast im Gleichschritt mit und hinge vom Stein ab.
+  Random random(seed ^ 0x636f72707573);
+  GameState state(seed, options.randomizer);
+  while (!state.gameOver && state.piecesPlaced < options.maxPieces) {
+    const std::vector<Action> *path;
+    if (random.below(100) < options.randomPercent) {
+      const std::vector<Tetromino> &placements =
+          generator.generate(state.field, state.currentTetromino);
+      if (placements.empty()) {
+        break;
+      }
+      path = &generator.pathTo(placements[random.below(placements.size())]);
+    } else {
+      path = &bot.planMoves(state);
+    }
+    if (path->empty()) {
+      break;
+    }
+    int sampled = -1;
+    if (state.piecesPlaced >= options.skipPieces &&
+        (state.piecesPlaced - options.skipPieces) % options.interval == 0) {
+      sampled = random.below(path->size());
+    }
+    for (int k = 0; k < static_cast<int>(path->size()); k++) {
+      if (k == sampled) {
+        records.push_back(makeRecord(state, seed));
+      }
+      applyAction(state, (*path)[k]);
+    }
+  }
+}
+} // namespace
+
+void CorpusRecord::loadField(Board &field, int color) const {
+  field.setRows(rows, color);
+}
+
+std::vector<CorpusRecord> generateCorpus(const CorpusOptions &options) {
+  if (options.numPositions < 0 || options.interval <= 0 ||
+      options.skipPieces < 0 || options.maxPieces <= options.skipPieces ||
+      options.randomPercent < 0 || options.randomPercent > 100) {
+    throw std::runtime_error("Invalid options for corpus");
+  }
+  const int numThreads =
+      options.numThreads > 0
+          ? options.numThreads
+          : std::max(1u, std::thread::hardware_concurrency());
+
+  // Die Spiele laufen in Runden von einigen pro Thread. Ihre Stellungen
+  // werden in der Reihenfolge der Seeds angehängt, bis es genug sind. Bringt
+  // eine ganze Runde keine Stellung (alle Spiele enden vor `skipPieces`),
+  // wird es auch danach nicht besser.
+  std::vector<CorpusRecord> records;
+  records.reserve(options.numPositions);
+  const int round = 4 * numThreads;
+  std::vector<std::vector<CorpusRecord>> games(round);
+  for (uint64_t first = options.firstSeed;
+       static_cast<int64_t>(records.size()) < options.numPositions;
+       first += round) {
+    std::atomic<int> nextGame(0);
+    auto worker = [&]() {
+      for (int game = nextGame++; game < round; game = nextGame++) {
+        games[game].clear();
+        playCorpusGame(options, first + game, games[game]);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back(worker);
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    size_t before = records.size();
+    for (const std::vector<CorpusRecord> &game : games) {
+      size_t count = std::min<size_t>(game.size(),
+                                      options.numPositions - records.size());
+      records.insert(records.end(), game.begin(), game.begin() + count);
+    }
+    if (records.size() == before) {
+      throw std::runtime_error(
+          "Corpus stopped after " + std::to_string(records.size()) + " of " +
+          std::to_string(options.numPositions) +
+          " positions: no game of the last round got past the skipped pieces");
+    }
+  }
+  return records;
+}
+
+void writeCorpus(const std::string &path, const CorpusOptions &options,
+                 const std::vector<CorpusRecord> &records) {
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw std::runtime_error("Could not open corpus file " + path);
+  }
+  CorpusHeader header = makeHeader(options, records.size());
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(records.data(), sizeof(CorpusRecord), records.size(),
+                        file) == records.size();
+  ok &= std::fclose(file) == 0;
+  if (!ok) {
+    throw std::runtime_error("Could not write corpus file " + path);
+  }
+}
+
+Corpus::Corpus(const std::string &path)
+    : records_(nullptr), size_(0), mapping_(nullptr), mappingSize_(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open corpus file " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 &&
+      static_cast<size_t>(info.st_size) >= sizeof(CorpusHeader)) {
+    mappingSize_ = info.st_size;
+    mapping_ = mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping_ == nullptr || mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::runtime_error("Could not map corpus file " + path);
+  }
+  std::memcpy(&header_, mapping_, sizeof(header_));
+  if (std::memcmp(header_.magic, CORPUS_MAGIC, 4) != 0 ||
+      header_.version != CORPUS_VERSION || header_.width != Board::kWidth ||
+      header_.height != Board::kHeight ||
+      header_.recordSize != sizeof(CorpusRecord) ||
+      header_.numRecords !=
+          (mappingSize_ - sizeof(CorpusHeader)) / sizeof(CorpusRecord) ||
+      (mappingSize_ - sizeof(CorpusHeader)) % sizeof(CorpusRecord) != 0) {
+    munmap(mapping_, mappingSize_);
+    throw std::runtime_error("Not a corpus file of version " +
+                             std::to_string(CORPUS_VERSION) + ": " + path);
+  }
+  // Der Header ist so groß wie ein Datensatz, die Datensätze liegen also
+  // wie die Abbildung selbst auf Cache-Zeilen.
+  records_ = reinterpret_cast<const CorpusRecord *>(
+      static_cast<const char *>(mapping_) + sizeof(CorpusHeader));
+  size_ = header_.numRecords;
+  madvise(mapping_, mappingSize_, MADV_SEQUENTIAL);
+}
+
+Corpus::Corpus(const CorpusOptions &options, std::vector<CorpusRecord> records)
+    : header_(makeHeader(options, records.size())), mapping_(nullptr),
+      mappingSize_(0), owned_(std::move(records)) {
+  records_ = owned_.data();
+  size_ = owned_.size();
+}
+
+Corpus::~Corpus() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mappingSize_);
+  }
+}
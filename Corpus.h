@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Board.h"
+#include "Tetromino.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Ein Korpus realistischer Stellungen für Benchmarks und Regressionstests:
+// Stellungen aus Spielen des Bots mit festen Seeds, jede mit dem Feld, dem
+// aktuellen Stein (irgendwo auf dem Weg, den er wirklich nimmt) und dem
+// nächsten Stein.
+//
+// Format (alle Zahlen little-endian): Header (`CorpusHeader`, 64 Bytes),
+// danach die Datensätze (`CorpusRecord`, je 64 Bytes) ohne Lücken. Die
+// Datei wird so, wie sie ist, in den Speicher abgebildet (mmap), ein
+// Datensatz ist also ohne Parsen oder Kopieren benutzbar und liegt auf einer
+// eigenen Cache-Zeile.
+//
+// Die Version ändert sich, wenn sich das Format oder die Erzeugung ändert
+// (Version 2: eigener Zufallsstrom für zufällige Züge). Die Datei wird
+// einmal erzeugt und dann aufgehoben: Ändert sich der Bot, ergeben dieselben
+// Optionen andere Stellungen, Messungen mit derselben Datei bleiben aber über
+// Änderungen am Spiel hinweg vergleichbar.
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Der Korpus wird direkt abgebildet, nur little-endian");
+
+const uint8_t CORPUS_VERSION = 2;
+
+struct CorpusOptions {
+  int64_t numPositions = 1 << 20;
+  // Spiel `i` benutzt den Seed `firstSeed + i`.
+  uint64_t firstSeed = 1;
+  // 0 heißt: so viele Threads wie Kerne. Das Ergebnis hängt nicht davon ab.
+  int numThreads = 0;
+  RandomizerMode randomizer = RandomizerMode::Bag;
+  // Ein Spiel endet spätestens nach so vielen Steinen. Die ersten
+  // `skipPieces` Steine (die Eröffnung auf fast leerem Feld) werden
+  // übersprungen, danach wird jeder `interval`-te Stein aufgenommen.
+  int maxPieces = 1000;
+  int skipPieces = 10;
+  int interval = 1;
+  // So viel Prozent der Steine setzt das Spiel an eine zufällige
+  // Endposition statt an die des Bots, damit die Stapel nicht nur so
+  // aufgeräumt sind, wie der Bot sie hinterlässt.
+  int randomPercent = 5;
+};
+
+// Der Header der Datei.
+struct CorpusHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t width;
+  uint8_t height;
+  uint8_t recordSize;
+  uint64_t numRecords;
+  // Die Optionen, mit denen der Korpus erzeugt wurde.
+  uint64_t firstSeed;
+  uint32_t maxPieces;
+  uint32_t skipPieces;
+  uint32_t interval;
+  uint8_t randomizer;
+  uint8_t randomPercent;
+  uint8_t reserved[26];
+};
+
+// Eine Stellung.
+struct CorpusRecord {
+  // Belegung des Feldes, oberste Zeile zuerst (siehe `Board::getRows`).
+  Board::Row rows[Board::kHeight];
+  // Der aktuelle Stein (Index in PIECES) mit Rotation und Position, und der
+  // nächste.
+  uint8_t piece;
+  uint8_t rotation;
+  int8_t row;
+  int8_t col;
+  uint8_t nextPiece;
+  uint8_t reserved[3];
+  // Woher die Stellung stammt: Seed des Spiels, bis dahin gesetzte Steine
+  // und entfernte Zeilen.
+  uint64_t seed;
+  uint32_t piecesPlaced;
+  uint32_t linesCleared;
+
+  // Das Feld, belegte Zellen in der Farbe `color`.
+  void loadField(Board &field, int color = 1) const;
+  Tetromino tetromino() const { return Tetromino(piece, rotation, row, col); }
+  Tetromino nextTetromino() const { return Tetromino(nextPiece); }
+};
+
+static_assert(sizeof(CorpusHeader) == 64, "Header mit 64 Bytes");
+static_assert(sizeof(CorpusRecord) == 64, "Datensatz mit 64 Bytes");
+
+// Spielt Spiele, bis `numPositions` Stellungen beisammen sind, in der
+// Reihenfolge der Seeds (und darin der Steine). Wirft eine Exception bei
+// ungültigen Optionen oder wenn eine Runde von Spielen gar keine Stellung
+// bringt.
+std::vector<CorpusRecord> generateCorpus(const CorpusOptions &options);
+
+// Schreibt `records` mit dem Header für `options` nach `path`. Wirft bei
+// Fehlern eine Exception.
+void writeCorpus(const std::string &path, const CorpusOptions &options,
+                 const std::vector<CorpusRecord> &records);
+
+// Ein Korpus zum Lesen: eine Datei von `writeCorpus`, in den Speicher
+// abgebildet, oder die Datensätze von `generateCorpus` direkt.
+class Corpus {
+public:
+  // Bildet die Datei ab. Wirft eine Exception, wenn sie fehlt oder nicht
+  // passt (anderes Format, andere Version, andere Größe des Feldes).
+  explicit Corpus(const std::string &path);
+  Corpus(const CorpusOptions &options, std::vector<CorpusRecord> records);
+  ~Corpus();
+  Corpus(const Corpus &) = delete;
+  Corpus &operator=(const Corpus &) = delete;
+
+  const CorpusHeader &header() const { return header_; }
+  size_t size() const { return size_; }
+  const CorpusRecord &operator[](size_t i) const { return records_[i]; }
+  const CorpusRecord *begin() const { return records_; }
+  const CorpusRecord *end() const { return records_ + size_; }
+
+private:
+  CorpusHeader header_;
+  const CorpusRecord *records_;
+  size_t size_;
+  // Die Abbildung der Datei bzw. die Datensätze im Speicher.
+  void *mapping_;
+  size_t mappingSize_;
+  std::vector<CorpusRecord> owned_;
+};
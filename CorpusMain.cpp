@@ -0,0 +1,80 @@
+#include "./Corpus.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+// Erzeugt einen Korpus von Stellungen (siehe Corpus.h) und schreibt ihn in
+// eine Datei, z.B. für `TETRIS_CORPUS=corpus.bin ./TetrisBench`.
+int main(int argc, char **argv) {
+  CorpusOptions options;
+  std::string path;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--positions") == 0 && hasValue) {
+      options.numPositions = std::strtoll(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      options.firstSeed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+      options.numThreads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--max-pieces") == 0 && hasValue) {
+      options.maxPieces = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--skip") == 0 && hasValue) {
+      options.skipPieces = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--interval") == 0 && hasValue) {
+      options.interval = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--random") == 0 && hasValue) {
+      options.randomPercent = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--classic") == 0) {
+      options.randomizer = RandomizerMode::Classic;
+    } else if (argv[i][0] != '-' && path.empty()) {
+      path = argv[i];
+    } else {
+      path.clear();
+      break;
+    }
+  }
+  if (path.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--positions N] [--seed S] [--threads N] [--max-pieces N]"
+                 " [--skip N] [--interval N] [--random PERCENT] [--classic]"
+                 " FILE"
+              << std::endl;
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<CorpusRecord> records;
+  try {
+    records = generateCorpus(options);
+    writeCorpus(path, options, records);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  uint64_t games = 0;
+  int64_t height = 0;
+  for (size_t i = 0; i < records.size(); i++) {
+    games += i == 0 || records[i].seed != records[i - 1].seed;
+    for (Board::Row row : records[i].rows) {
+      height += row != 0;
+    }
+  }
+  std::cout << "Positions:  " << records.size() << " from " << games
+            << " games" << std::endl;
+  std::cout << "Stack:      "
+            << (records.empty() ? 0.0
+                                : static_cast<double>(height) / records.size())
+            << " rows on average" << std::endl;
+  std::cout << "File:       " << path << " ("
+            << sizeof(CorpusHeader) + records.size() * sizeof(CorpusRecord)
+            << " bytes, version " << static_cast<int>(CORPUS_VERSION) << ")"
+            << std::endl;
+  std::cout << "Time:       " << seconds << " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+DurationHistogram::DurationHistogram() { reset(); }
+
+void DurationHistogram::reset() {
+  buckets_.fill(0);
+  count_ = 0;
+  total_ = 0;
+  max_ = 0;
+}
+
+int DurationHistogram::bucketOf(uint64_t nanos) {
+  // Unterhalb von 2^kSubBits ein Bucket pro Wert, darüber die Zweierpotenz
+  // und die kSubBits Bits nach dem höchsten.
+  if (nanos < (1u << kSubBits)) {
+    return nanos;
+  }
+  int msb = 63 - __builtin_clzll(nanos);
+  int sub = (nanos >> (msb - kSubBits)) & ((1 << kSubBits) - 1);
+  return ((msb - kSubBits + 1) << kSubBits) + sub;
+}
+
+int64_t DurationHistogram::upperBound(int bucket) {
+  if (bucket < (1 << kSubBits)) {
+    return bucket;
+  }
+  int msb = (bucket >> kSubBits) + kSubBits - 1;
+  int64_t sub = bucket & ((1 << kSubBits) - 1);
+  return (((1 << kSubBits) + sub + 1) << (msb - kSubBits)) - 1;
+}
+
+void DurationHistogram::record(int64_t nanos) {
+  if (nanos < 0) {
+    nanos = 0;
+  }
+  buckets_[bucketOf(nanos)]++;
+  count_++;
+  total_ += nanos;
+  if (nanos > max_) {
+    max_ = nanos;
+  }
+}
+
+int64_t DurationHistogram::percentile(double p) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  int64_t rank = static_cast<int64_t>(p * count_);
+  if (rank >= count_) {
+    rank = count_ - 1;
+  }
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < kNumBuckets; bucket++) {
+    seen += buckets_[bucket];
+    if (seen > rank) {
+      return std::min(upperBound(bucket), max_);
+    }
+  }
+  return max_;
+}
+
+FrameStats::FrameStats()
+    : start_(Clock::now()), lastLap_(start_), framesDrawn_(0) {}
+
+void FrameStats::startFrame() { lastLap_ = Clock::now(); }
+
+void FrameStats::lap(FramePhase phase) {
+  Clock::time_point now = Clock::now();
+  phases_[static_cast<int>(phase)].record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastLap_)
+          .count());
+  lastLap_ = now;
+}
+
+const char *FrameStats::phaseName(FramePhase phase) {
+  switch (phase) {
+  case FramePhase::Input:
+    return "input";
+  case FramePhase::Logic:
+    return "logic";
+  case FramePhase::Compose:
+    return "compose";
+  case FramePhase::Draw:
+    return "draw";
+  case FramePhase::NumPhases:
+    break;
+  }
+  return "?";
+}
+
+double FrameStats::framesPerSecond() const {
+  double seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+  return seconds > 0 ? framesDrawn_ / seconds : 0;
+}
+
+std::string FrameStats::overlayLine(int line) const {
+  char text[64];
+  if (line == 0) {
+    std::snprintf(text, sizeof(text), "fps %-6.1f  p50/p99/max us",
+                  framesPerSecond());
+  } else {
+    FramePhase p = static_cast<FramePhase>(line - 1);
+    const DurationHistogram &histogram = phase(p);
+    std::snprintf(text, sizeof(text), "%-7s %6lld %6lld %7lld", phaseName(p),
+                  static_cast<long long>(histogram.percentile(0.5) / 1000),
+                  static_cast<long long>(histogram.percentile(0.99) / 1000),
+                  static_cast<long long>(histogram.max() / 1000));
+  }
+  return text;
+}
+
+void FrameStats::writeCsv(const std::string &path) const {
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    throw std::runtime_error("Could not open " + path);
+  }
+  std::fprintf(file, "phase,count,p50_ns,p99_ns,max_ns,mean_ns\n");
+  for (int i = 0; i < static_cast<int>(FramePhase::NumPhases); i++) {
+    const DurationHistogram &histogram = phases_[i];
+    std::fprintf(file, "%s,%lld,%lld,%lld,%lld,%lld\n",
+                 phaseName(static_cast<FramePhase>(i)),
+                 static_cast<long long>(histogram.count()),
+                 static_cast<long long>(histogram.percentile(0.5)),
+                 static_cast<long long>(histogram.percentile(0.99)),
+                 static_cast<long long>(histogram.max()),
+                 static_cast<long long>(
+                     histogram.count() ? histogram.total() / histogram.count()
+                                       : 0));
+  }
+  std::fprintf(file, "frames_per_second,%lld,%.2f,,,\n",
+               static_cast<long long>(framesDrawn_), framesPerSecond());
+  std::fclose(file);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Zeitmessung für die Phasen der Hauptschleife. Die Zeiten landen in
+// Histogrammen mit logarithmischen Buckets (8 pro Zweierpotenz, also etwa
+// 12% Auflösung), das Aufzeichnen ist ein paar Additionen und kostet keinen
+// Speicher.
+
+// Histogramm über Dauern in Nanosekunden.
+class DurationHistogram {
+public:
+  DurationHistogram();
+
+  void record(int64_t nanos);
+
+  // Das p-Quantil (p in [0, 1]), als Obergrenze des Buckets; 0 wenn leer.
+  int64_t percentile(double p) const;
+  int64_t max() const { return max_; }
+  int64_t count() const { return count_; }
+  int64_t total() const { return total_; }
+
+  void reset();
+
+private:
+  static constexpr int kSubBits = 3;
+  static constexpr int kNumBuckets = 64 << kSubBits;
+  static int bucketOf(uint64_t nanos);
+  static int64_t upperBound(int bucket);
+
+  std::array<uint32_t, kNumBuckets> buckets_;
+  int64_t count_;
+  int64_t total_;
+  int64_t max_;
+};
+
+// Die Phasen eines Durchlaufs der Hauptschleife.
+enum class FramePhase {
+  Input,   // Lesen der Eingaben (`getUserInput`), ohne das Warten davor
+  Logic,   // Spiellogik (`step` usw.)
+  Compose, // Bild des Feldes mit Stein zusammensetzen
+  Draw,    // Zellen ans Terminal schicken und `refresh`
+  NumPhases
+};
+
+class FrameStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FrameStats();
+
+  // Beginnt einen Durchlauf; jedes `lap` misst die Zeit seit dem vorigen
+  // `lap` (bzw. `startFrame`) als Dauer der gegebenen Phase.
+  void startFrame();
+  void lap(FramePhase phase);
+
+  // Beendet einen Durchlauf, in dem tatsächlich gezeichnet wurde.
+  void frameDrawn() { framesDrawn_++; }
+
+  const DurationHistogram &phase(FramePhase phase) const {
+    return phases_[static_cast<int>(phase)];
+  }
+  static const char *phaseName(FramePhase phase);
+
+  // Gezeichnete Frames pro Sekunde seit Beginn der Messung.
+  double framesPerSecond() const;
+
+  // Die Zeilen für die Anzeige neben dem Spielfeld, Zeile 0 sind die Frames
+  // pro Sekunde, dann eine Zeile pro Phase.
+  std::string overlayLine(int line) const;
+  static constexpr int kOverlayLines =
+      1 + static_cast<int>(FramePhase::NumPhases);
+
+  // Schreibt alle Werte als CSV. Wirft bei Fehlern eine Exception.
+  void writeCsv(const std::string &path) const;
+
+private:
+  std::array<DurationHistogram, static_cast<int>(FramePhase::NumPhases)>
+      phases_;
+  Clock::time_point start_;
+  Clock::time_point lastLap_;
+  int64_t framesDrawn_;
+};
@@ -0,0 +1,211 @@
+#include "Game.h"
+#include <ctime>
+
+const int LEVEL_SPEEDS[] = {48, 43, 38, 33, 28, 23, 18, 13, 8, 6,
+                            5,  5,  5,  4,  4,  4,  3,  3,  3, 2,
+                            2,  2,  2,  2,  2,  2,  2,  2,  2, 1};
+
+namespace {
+// Der nächste Stein aus `tetrominos`, auf einem breiteren Feld als `Board`
+// nach rechts in die Mitte geschoben.
+template <class B> Tetromino spawn(Tetrominos &tetrominos) {
+  Tetromino tetromino = tetrominos.getRandomTetromino();
+  if (B::kWidth != Board::kWidth) {
+    auto [row, col] = tetromino.getPosition();
+    tetromino.setPosition(row, col + (B::kWidth - Board::kWidth) / 2);
+  }
+  return tetromino;
+}
+} // namespace
+
+template <class B>
+BasicGameState<B>::BasicGameState() : BasicGameState(std::time(nullptr)) {}
+
+template <class B>
+BasicGameState<B>::BasicGameState(uint64_t seed, RandomizerMode mode,
+                                  int previewSize)
+    : tetrominos(seed, mode, previewSize),
+      currentTetromino(spawn<B>(tetrominos)),
+      nextTetromino(spawn<B>(tetrominos)), framesPerRow(calculateTickRate(0)) {}
+
+template <class B> bool applyAction(BasicGameState<B> &state, Action action) {
+  if (state.gameOver) {
+    return false;
+  }
+  Tetromino &tetromino = state.currentTetromino;
+  Tetromino before = tetromino;
+  bool moved = false;
+  switch (action) {
+  case Action::None:
+    return false;
+  case Action::Left:
+    moved = tetromino.move(-1, 0, state.field);
+    break;
+  case Action::Right:
+    moved = tetromino.move(1, 0, state.field);
+    break;
+  case Action::SoftDrop:
+    if (!tetromino.move(0, 1, state.field)) {
+      lockTetromino(state);
+    } else {
+      state.rotatedLast = false;
+    }
+    return true;
+  case Action::HardDrop:
+    if (tetromino.hardDrop(state.field) > 0) {
+      state.rotatedLast = false;
+    }
+    lockTetromino(state);
+    return true;
+  case Action::RotateClockwise:
+    tetromino.rotateClockwise(state.field);
+    break;
+  case Action::RotateCounterClockwise:
+    tetromino.rotateCounterClockwise(state.field);
+    break;
+  }
+  if (moved) {
+    state.rotatedLast = false;
+    return true;
+  }
+  if (tetromino.getRotation() != before.getRotation()) {
+    state.rotatedLast = true;
+    return true;
+  }
+  return false;
+}
+
+template <class B> void step(BasicGameState<B> &state, Action action) {
+  if (state.gameOver) {
+    return;
+  }
+  applyAction(state, action);
+  state.frame++;
+  if (++state.gravityFrames >= state.framesPerRow && !state.gameOver) {
+    state.gravityFrames = 0;
+    if (state.currentTetromino.move(0, 1, state.field)) {
+      state.rotatedLast = false;
+    } else {
+      lockTetromino(state);
+    }
+  }
+}
+
+template <class B> void lockTetromino(BasicGameState<B> &state) {
+  BasicClearEvent<B> event;
+  if (state.rotatedLast) {
+    event.tSpin = detectTSpin(state.field, state.currentTetromino);
+  }
+  placeTetrominoInField(state.field, state.currentTetromino);
+  event.lines = state.field.clearFullLines(&event.rows);
+  if (event.lines > 0) {
+    event.combo = state.lastClear.combo + 1;
+    bool difficult = event.lines == 4 || event.tSpin != TSpin::None;
+    event.backToBack = difficult && state.difficultLast;
+    state.difficultLast = difficult;
+  }
+  event.score = scoreFor(event, state.level);
+  state.score += event.score;
+  state.totalLinesCleared += event.lines;
+  state.lastClear = event;
+  state.rotatedLast = false;
+  state.piecesPlaced++;
+  state.currentTetromino = state.nextTetromino;
+  state.nextTetromino = spawn<B>(state.tetrominos);
+  if (!state.currentTetromino.move(0, 0, state.field)) {
+    state.gameOver = true;
+  }
+  int previousLevel = state.level;
+  state.level = state.totalLinesCleared / 10;
+  if (state.level != previousLevel) {
+    state.framesPerRow = calculateTickRate(state.level);
+  }
+}
+
+namespace {
+// Mittelpunkt des T in seiner Bounding Box und die Richtung, in die es zeigt,
+// pro Rotation (siehe PIECES).
+struct TCenter {
+  int8_t row, col, dirRow, dirCol;
+};
+const TCenter T_CENTERS[4] = {
+    {0, 1, 1, 0}, {1, 1, 0, -1}, {1, 1, -1, 0}, {1, 0, 0, 1}};
+
+// Punkte nach Art des T-Spins und Anzahl der Zeilen. Ein Mini räumt höchstens
+// zwei Zeilen, ein T höchstens drei.
+const int CLEAR_SCORES[3][5] = {{0, 100, 300, 500, 800},
+                                {100, 200, 400, 400, 400},
+                                {400, 800, 1200, 1600, 1600}};
+} // namespace
+
+template <class B>
+TSpin detectTSpin(const B &field, const Tetromino &tetromino) {
+  if (tetromino.getPiece() != PIECE_T) {
+    return TSpin::None;
+  }
+  const TCenter &center = T_CENTERS[tetromino.getRotation()];
+  auto [row, col] = tetromino.getPosition();
+  int corners = 0;
+  int front = 0;
+  for (int dr : {-1, 1}) {
+    for (int dc : {-1, 1}) {
+      int r = row + center.row + dr;
+      int c = col + center.col + dc;
+      bool occupied = c < 0 || c >= B::kWidth || r >= B::kHeight ||
+                      (r >= 0 && field.isOccupied(r, c));
+      corners += occupied;
+      if (dr * center.dirRow + dc * center.dirCol > 0) {
+        front += occupied;
+      }
+    }
+  }
+  if (corners < 3) {
+    return TSpin::None;
+  }
+  return front == 2 ? TSpin::Full : TSpin::Mini;
+}
+
+template <class B> int scoreFor(const BasicClearEvent<B> &event, int level) {
+  int score = CLEAR_SCORES[static_cast<int>(event.tSpin)][event.lines] *
+              (level + 1);
+  if (event.backToBack) {
+    score = score * 3 / 2;
+  }
+  if (event.combo > 0) {
+    score += 50 * event.combo * (level + 1);
+  }
+  return score;
+}
+
+int calculateTickRate(int level) {
+  if (level >= 29) {
+    return LEVEL_SPEEDS[29];
+  }
+  return LEVEL_SPEEDS[level];
+}
+
+// Für alle Größen aus Board.h.
+template struct BasicGameState<Board>;
+template bool applyAction(BasicGameState<Board> &, Action);
+template void step(BasicGameState<Board> &, Action);
+template void lockTetromino(BasicGameState<Board> &);
+template TSpin detectTSpin(const Board &, const Tetromino &);
+template int scoreFor(const BasicClearEvent<Board> &, int);
+template struct BasicGameState<TallBoard>;
+template bool applyAction(BasicGameState<TallBoard> &, Action);
+template void step(BasicGameState<TallBoard> &, Action);
+template void lockTetromino(BasicGameState<TallBoard> &);
+template TSpin detectTSpin(const TallBoard &, const Tetromino &);
+template int scoreFor(const BasicClearEvent<TallBoard> &, int);
+template struct BasicGameState<WideBoard>;
+template bool applyAction(BasicGameState<WideBoard> &, Action);
+template void step(BasicGameState<WideBoard> &, Action);
+template void lockTetromino(BasicGameState<WideBoard> &);
+template TSpin detectTSpin(const WideBoard &, const Tetromino &);
+template int scoreFor(const BasicClearEvent<WideBoard> &, int);
+template struct BasicGameState<HugeBoard>;
+template bool applyAction(BasicGameState<HugeBoard> &, Action);
+template void step(BasicGameState<HugeBoard> &, Action);
+template void lockTetromino(BasicGameState<HugeBoard> &);
+template TSpin detectTSpin(const HugeBoard &, const Tetromino &);
+template int scoreFor(const BasicClearEvent<HugeBoard> &, int);
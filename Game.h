@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Board.h"
+#include "Tetromino.h"
+#include <cstdint>
+
+// Die Spielregeln ohne Terminal, Uhr und Zeichnen. Ein Frontend übersetzt
+// seine Eingaben in `Action`s und ruft `step` einmal pro Frame (1/60 s) auf,
+// ein Bot oder eine Simulation kann das so schnell tun wie es will.
+
+// So viele Frames simuliert `step` pro Sekunde Spielzeit.
+const int FRAMES_PER_SECOND = 60;
+
+// Die Eingaben, die ein Spieler machen kann.
+enum class Action : uint8_t {
+  None,
+  Left,
+  Right,
+  SoftDrop,
+  RotateClockwise,
+  RotateCounterClockwise,
+  HardDrop,
+};
+
+// Art eines T-Spins: Der zuletzt erfolgreiche Zug vor dem Festsetzen war
+// eine Rotation und mindestens drei der vier Ecken um den Mittelpunkt des T
+// sind belegt (Wände und Boden zählen als belegt). Sind beide Ecken auf der
+// Seite belegt, auf die das T zeigt, ist es ein voller T-Spin, sonst ein
+// Mini.
+enum class TSpin : uint8_t { None, Mini, Full };
+
+// Was beim Festsetzen eines Steins passiert ist: Grundlage für Punkte,
+// Anzeige und Animationen. Wird bei jedem Stein neu gesetzt, auch wenn keine
+// Zeile entfernt wurde.
+template <class B> struct BasicClearEvent {
+  int lines = 0;
+  // Die entfernten Zeilen, nummeriert wie vor dem Entfernen.
+  typename B::RowMask rows;
+  TSpin tSpin = TSpin::None;
+  // Anzahl der Steine mit entfernten Zeilen direkt hintereinander minus 1, -1
+  // ohne entfernte Zeilen.
+  int combo = -1;
+  // Ein Tetris oder T-Spin mit Zeilen direkt nach einem ebensolchen (Steine
+  // ohne Zeilen dazwischen unterbrechen das nicht).
+  bool backToBack = false;
+  int score = 0;
+};
+
+// Der komplette Zustand eines Spiels auf einem Feld vom Typ `B`. Das Spiel
+// benutzt `GameState` (10x20), die größeren Felder aus Board.h sind für
+// Stresstests (siehe `SelfPlayOptions::boardWidth`). Die Steine erscheinen
+// dort mittig. Die Implementierung steht in Game.cpp und wird dort für genau
+// diese Größen instanziiert.
+template <class B> struct BasicGameState {
+  // Neues Spiel mit zufälligem bzw. festem Seed für die Folge der Steine
+  // (siehe `Tetrominos`).
+  BasicGameState();
+  explicit BasicGameState(uint64_t seed,
+                          RandomizerMode mode = RandomizerMode::Classic,
+                          int previewSize = 1);
+
+  B field;
+  Tetrominos tetrominos;
+  Tetromino currentTetromino;
+  Tetromino nextTetromino;
+  int level = 0;
+  int totalLinesCleared = 0;
+  int64_t score = 0;
+  // Das Ergebnis des zuletzt festgesetzten Steins.
+  BasicClearEvent<B> lastClear;
+  // Ob der letzte erfolgreiche Zug des aktuellen Steins eine Rotation war
+  // (für T-Spins), und ob das letzte Entfernen von Zeilen ein Tetris oder
+  // T-Spin war (für Back-to-Back).
+  bool rotatedLast = false;
+  bool difficultLast = false;
+  // Anzahl der Frames, die ein Stein pro Zeile fällt (siehe LEVEL_SPEEDS).
+  int framesPerRow;
+  // Frames seit dem letzten Fallen des Steins.
+  int gravityFrames = 0;
+  // Anzahl der bisher simulierten Frames und festgesetzten Steine.
+  int64_t frame = 0;
+  int piecesPlaced = 0;
+  bool gameOver = false;
+};
+
+using ClearEvent = BasicClearEvent<Board>;
+using GameState = BasicGameState<Board>;
+
+// Führt eine Eingabe sofort aus, ohne dass Zeit vergeht. Ein Soft Drop, der
+// nicht mehr möglich ist, setzt den Stein fest, ein Hard Drop lässt ihn
+// sofort ganz fallen und setzt ihn fest. Gibt zurück, ob sich der
+// Zustand geändert hat.
+template <class B> bool applyAction(BasicGameState<B> &state, Action action);
+
+// Simuliert genau einen Frame: erst die Eingabe, dann die Schwerkraft.
+template <class B> void step(BasicGameState<B> &state, Action action);
+
+// Setzt den aktuellen Stein an seiner Position fest, entfernt volle Zeilen,
+// setzt `lastClear` und die Punkte und holt den nächsten Stein. Passt dieser
+// nicht mehr ins Feld, ist das Spiel vorbei.
+template <class B> void lockTetromino(BasicGameState<B> &state);
+
+// Die Art des T-Spins, wenn `tetromino` jetzt in `field` festgesetzt würde
+// und der letzte Zug eine Rotation war.
+template <class B>
+TSpin detectTSpin(const B &field, const Tetromino &tetromino);
+
+// Punkte für ein Ereignis im gegebenen Level (Tabelle der Tetris-Guideline,
+// mal Level + 1; Back-to-Back mal 1,5; 50 pro Combo-Stufe).
+template <class B> int scoreFor(const BasicClearEvent<B> &event, int level);
+
+// Anzahl der Frames pro Zeile für das gegebene Level.
+int calculateTickRate(int level);
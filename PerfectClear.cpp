@@ -0,0 +1,266 @@
+#include "PerfectClear.h"
+#include <algorithm>
+#include <bitset>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+// Eine Stellung nach den ersten beiden Steinen, aufgeteilt auf die Threads.
+struct Task {
+  Board field;
+  int height;
+  Tetromino first;
+  Tetromino second;
+};
+
+int popcount(Board::Row row) { return std::bitset<Board::kWidth>(row).count(); }
+} // namespace
+
+PerfectClearSolver::PerfectClearSolver(const PerfectClearOptions &options)
+    : options_(options),
+      numThreads_(options.numThreads > 0
+                      ? options.numThreads
+                      : std::max(1u, std::thread::hardware_concurrency())),
+      table_(options.tableLog2Entries), solvedTask_(INT_MAX) {}
+
+PerfectClearResult PerfectClearSolver::solve(const GameState &state) {
+  std::vector<int> queue = {state.currentTetromino.getPiece(),
+                            state.nextTetromino.getPiece()};
+  for (int i = 0; i < state.tetrominos.previewSize(); i++) {
+    queue.push_back(state.tetrominos.peek(i));
+  }
+  return solve(state.field, queue);
+}
+
+PerfectClearResult PerfectClearSolver::solve(const Board &field,
+                                             const std::vector<int> &queue) {
+  PerfectClearResult result;
+  queue_ = queue;
+  int stack = 0;
+  int filled = 0;
+  for (int col = 0; col < Board::kWidth; col++) {
+    stack = std::max(stack, field.columnHeight(col));
+  }
+  for (Board::Row row : field.getRows()) {
+    filled += popcount(row);
+  }
+  int minHeight = options_.height > 0 ? options_.height : std::max(1, stack);
+  int maxHeight = options_.height > 0 ? options_.height : kMaxHeight;
+  if (stack > minHeight || maxHeight > kMaxHeight) {
+    return result;
+  }
+  for (int height = minHeight; height <= maxHeight; height++) {
+    int empty = height * Board::kWidth - filled;
+    if (empty % 4 != 0) {
+      continue;
+    }
+    if (empty / 4 > static_cast<int>(queue_.size())) {
+      break;
+    }
+    if (solveHeight(field, height, result)) {
+      result.found = true;
+      result.height = height;
+      break;
+    }
+  }
+  return result;
+}
+
+bool PerfectClearSolver::solveHeight(const Board &field, int height,
+                                     PerfectClearResult &result) {
+  const int depth = queue_.size();
+  auto makeWorker = [depth]() {
+    Worker worker;
+    worker.generators.resize(depth);
+    worker.placements.resize(depth);
+    return worker;
+  };
+  uint64_t key;
+  if (!feasible(field, height, 0, key)) {
+    return false;
+  }
+
+  // Die Paare der ersten beiden Endpositionen sammelt dieser Thread selbst.
+  // Wer schon mit einem oder zwei Steinen fertig ist, braucht keine Threads.
+  Worker main = makeWorker();
+  std::vector<Task> tasks;
+  for (const Tetromino &first : placementsFor(main, field, height, 0)) {
+    main.nodes++;
+    Board afterFirst = field;
+    placeTetrominoInField(afterFirst, first);
+    int firstHeight = height - afterFirst.clearFullLines();
+    if (firstHeight == 0) {
+      result.placements = {first};
+      result.nodes += main.nodes;
+      return true;
+    }
+    if (!feasible(afterFirst, firstHeight, 1, key)) {
+      continue;
+    }
+    for (const Tetromino &second :
+         placementsFor(main, afterFirst, firstHeight, 1)) {
+      Task task{afterFirst, firstHeight, first, second};
+      placeTetrominoInField(task.field, second);
+      task.height -= task.field.clearFullLines();
+      tasks.push_back(task);
+    }
+  }
+  result.nodes += main.nodes;
+
+  std::vector<std::vector<Tetromino>> paths(tasks.size());
+  std::atomic<int> nextTask(0);
+  std::atomic<int64_t> nodes(0);
+  std::atomic<int64_t> tableHits(0);
+  solvedTask_ = INT_MAX;
+  auto run = [&]() {
+    Worker worker = makeWorker();
+    while (true) {
+      int task = nextTask++;
+      if (task >= static_cast<int>(tasks.size()) || task > solvedTask_) {
+        break;
+      }
+      worker.task = task;
+      worker.path.clear();
+      if (search(worker, tasks[task].field, tasks[task].height, 2)) {
+        paths[task] = worker.path;
+        int solved = solvedTask_;
+        while (task < solved &&
+               !solvedTask_.compare_exchange_weak(solved, task)) {
+        }
+      }
+    }
+    nodes += worker.nodes;
+    tableHits += worker.tableHits;
+  };
+  int numThreads = std::min<int>(numThreads_, tasks.size());
+  if (numThreads <= 1) {
+    run();
+  } else {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back(run);
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+  result.nodes += nodes;
+  result.tableHits += tableHits;
+
+  int solved = solvedTask_;
+  if (solved == INT_MAX) {
+    return false;
+  }
+  result.placements = {tasks[solved].first, tasks[solved].second};
+  result.placements.insert(result.placements.end(), paths[solved].begin(),
+                           paths[solved].end());
+  return true;
+}
+
+bool PerfectClearSolver::search(Worker &worker, const Board &field,
+                                int height, int depth) {
+  if (height == 0) {
+    return true;
+  }
+  worker.nodes++;
+  // Ein früheres Paar hat schon eine Lösung.
+  if (solvedTask_.load(std::memory_order_relaxed) < worker.task) {
+    return false;
+  }
+  uint64_t key;
+  if (!feasible(field, height, depth, key)) {
+    return false;
+  }
+  float value;
+  if (table_.probe(key, value)) {
+    worker.tableHits++;
+    return false;
+  }
+
+  for (const Tetromino &placement :
+       placementsFor(worker, field, height, depth)) {
+    Board next = field;
+    placeTetrominoInField(next, placement);
+    int lines = next.clearFullLines();
+    worker.path.push_back(placement);
+    if (search(worker, next, height - lines, depth + 1)) {
+      return true;
+    }
+    worker.path.pop_back();
+  }
+  // Nach einem Abbruch ist nicht alles durchsucht, das Ergebnis also nichts
+  // für die Tabelle. Abbrüche bleiben bestehen, ein Kind, das abgebrochen
+  // hat, fällt also auch hier auf.
+  if (solvedTask_.load(std::memory_order_relaxed) >= worker.task) {
+    table_.store(key, 0);
+  }
+  return false;
+}
+
+bool PerfectClearSolver::feasible(const Board &field, int height, int depth,
+                                  uint64_t &key) const {
+  const auto &rows = field.getRows();
+  // Leere Zellen pro Spalte, und zwischen welchen Spalten kein Stein mehr
+  // hindurch kann (Bit `c` für die Grenze zwischen `c` und `c + 1`).
+  int columnEmpty[Board::kWidth] = {};
+  Board::Row walls = Board::kFullRow;
+  for (int row = Board::kHeight - height; row < Board::kHeight; row++) {
+    Board::Row bits = rows[row];
+    walls &= bits | (bits >> 1);
+    for (int col = 0; col < Board::kWidth; col++) {
+      columnEmpty[col] += ((bits >> col) & 1) ^ 1;
+    }
+  }
+  int empty = 0;
+  int evenMinusOdd = 0;
+  int section = 0;
+  for (int col = 0; col < Board::kWidth; col++) {
+    empty += columnEmpty[col];
+    evenMinusOdd += col % 2 == 0 ? columnEmpty[col] : -columnEmpty[col];
+    section += columnEmpty[col];
+    if (col == Board::kWidth - 1 || ((walls >> col) & 1)) {
+      if (section % 4 != 0) {
+        return false;
+      }
+      section = 0;
+    }
+  }
+  const int needed = empty / 4;
+  if (depth + needed > static_cast<int>(queue_.size())) {
+    return false;
+  }
+
+  // Spaltenparität der Steine, die die Zone noch füllen.
+  int lj = 0;
+  int t = 0;
+  int i = 0;
+  key = field.hash();
+  for (int k = 0; k < needed; k++) {
+    int piece = queue_[depth + k];
+    lj += piece == PIECE_L || piece == PIECE_J;
+    t += piece == PIECE_T;
+    i += piece == PIECE_I;
+    key ^= TranspositionTable::pieceKey(k, piece);
+  }
+  if (std::abs(evenMinusOdd) > 2 * (lj + t) + 4 * i) {
+    return false;
+  }
+  // Ohne T ist der Unterschied durch 4 teilbar, wenn L und J zusammen eine
+  // gerade Anzahl sind, sonst nicht.
+  return t > 0 || (evenMinusOdd / 2 - lj) % 2 == 0;
+}
+
+const std::vector<Tetromino> &
+PerfectClearSolver::placementsFor(Worker &worker, const Board &field,
+                                  int height, int depth) {
+  std::vector<Tetromino> &placements = worker.placements[depth];
+  placements.clear();
+  for (const Tetromino &placement : worker.generators[depth].generate(
+           field, Tetromino(queue_[depth]))) {
+    if (placement.getPosition().first >= Board::kHeight - height) {
+      placements.push_back(placement);
+    }
+  }
+  return placements;
+}
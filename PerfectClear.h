@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Board.h"
+#include "Game.h"
+#include "Placement.h"
+#include "Tetromino.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Sucht einen Perfect Clear: eine Folge von Endpositionen für die kommenden
+// Steine (in dieser Reihenfolge, ohne Hold), nach der das Feld komplett leer
+// ist. Gesucht wird nur in den untersten Zeilen des Feldes (der "Zone"), kein
+// Stein darf darüber hinausragen.
+
+struct PerfectClearOptions {
+  // Höhe der Zone in Zeilen. 0 heißt: alle Höhen von der kleinsten, die den
+  // Stapel enthält, bis `kMaxHeight` der Reihe nach, solange die Steine
+  // reichen.
+  int height = 0;
+  // 0 heißt: so viele Threads wie Kerne.
+  int numThreads = 0;
+  // Größe der Tabelle der Stellungen ohne Lösung (2^`tableLog2Entries`
+  // Einträge). Sie bleibt über mehrere Aufrufe von `solve` erhalten.
+  int tableLog2Entries = 20;
+};
+
+struct PerfectClearResult {
+  bool found = false;
+  // Die Endpositionen der Steine der Reihe nach, jede im Feld, wie es nach den
+  // vorherigen (inklusive entfernter Zeilen) aussieht. Jede ist mit den
+  // Eingaben von `PlacementGenerator::pathTo` vom Startpunkt des Steins aus
+  // erreichbar.
+  std::vector<Tetromino> placements;
+  // Die Höhe der Zone, in der die Lösung gefunden wurde.
+  int height = 0;
+  // Besuchte Stellungen und Stellungen, deren Ergebnis schon in der Tabelle
+  // stand.
+  int64_t nodes = 0;
+  int64_t tableHits = 0;
+};
+
+// Tiefensuche über alle erreichbaren Endpositionen (`PlacementGenerator`).
+// Eine Stellung wird verworfen, ohne Steine zu setzen, wenn
+//   - die leeren Zellen der Zone mehr Steine brauchen, als noch kommen,
+//   - die Spaltenparität nicht passt: I, O, S, Z und ein liegendes T füllen
+//     gleich viele Zellen in geraden und ungeraden Spalten, L und J immer zwei
+//     mehr auf einer Seite, ein stehendes T zwei und ein stehendes I vier.
+//     Anders als ein Schachbrettmuster bleibt das beim Entfernen von Zeilen
+//     erhalten.
+//   - sie in Abschnitte zerfällt, deren leere Zellen keine Vielfachen von 4
+//     sind: Zwischen zwei Spalten, von denen in jeder Zeile der Zone
+//     mindestens eine belegt ist, kann kein Stein mehr hindurch.
+//   - sie schon einmal ohne Lösung durchsucht wurde (`TranspositionTable`,
+//     Schlüssel aus Feld und den Steinen, die sie noch braucht).
+// Die Suche teilt die Paare von Endpositionen der ersten beiden Steine auf
+// die Threads auf. Gefunden wird immer die Lösung des ersten Paares (in der
+// Reihenfolge des Generators), das eine hat, das Ergebnis hängt also nicht von
+// der Anzahl der Threads ab.
+class PerfectClearSolver {
+public:
+  // Höchste Zone, mehr passt nicht in die Tabelle der Steine.
+  static constexpr int kMaxHeight = 6;
+
+  explicit PerfectClearSolver(const PerfectClearOptions &options = {});
+
+  // Sucht für die Steine `queue` (Index in PIECES), jeder ab seinem
+  // Startpunkt. Belegte Zellen über der Zone heißen: keine Lösung.
+  PerfectClearResult solve(const Board &field, const std::vector<int> &queue);
+
+  // Dasselbe für den aktuellen Stein, den nächsten und die Vorschau eines
+  // Spiels.
+  PerfectClearResult solve(const GameState &state);
+
+private:
+  // Zustand eines Threads: ein Generator und die Endpositionen pro Tiefe,
+  // dazu der Weg zur aktuellen Stellung.
+  struct Worker {
+    std::vector<PlacementGenerator> generators;
+    std::vector<std::vector<Tetromino>> placements;
+    std::vector<Tetromino> path;
+    int task = 0;
+    int64_t nodes = 0;
+    int64_t tableHits = 0;
+  };
+
+  // Sucht für eine feste Höhe und gibt zurück, ob es eine Lösung gibt.
+  bool solveHeight(const Board &field, int height, PerfectClearResult &result);
+
+  // Ob `field` mit der Zone `height` und den Steinen ab `depth` gelöst werden
+  // kann. Der Weg steht danach in `worker.path`.
+  bool search(Worker &worker, const Board &field, int height, int depth);
+
+  // Die Prüfungen oben (ohne Tabelle). `key` ist danach der Tabellenschlüssel.
+  bool feasible(const Board &field, int height, int depth,
+                uint64_t &key) const;
+
+  // Die Endpositionen von Stein `depth`, die in der Zone bleiben. Die
+  // Referenz ist bis zum nächsten Aufruf für dieselbe Tiefe gültig.
+  const std::vector<Tetromino> &placementsFor(Worker &worker,
+                                              const Board &field, int height,
+                                              int depth);
+
+  PerfectClearOptions options_;
+  int numThreads_;
+  TranspositionTable table_;
+  std::vector<int> queue_;
+  // Das kleinste Paar von Endpositionen mit Lösung; größere brechen ab.
+  std::atomic<int> solvedTask_;
+};
@@ -0,0 +1,80 @@
+#include "./PerfectClear.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Sucht Perfect Clears vom leeren Feld aus für viele zufällige Folgen von
+// Steinen (7-Bag, Seeds `seed` bis `seed + queries - 1`) und gibt aus, wie
+// viele lösbar waren und wie lange die Suche gedauert hat.
+int main(int argc, char **argv) {
+  PerfectClearOptions options;
+  int queries = 100;
+  int pieces = 10;
+  uint64_t firstSeed = 1;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--queries") == 0 && hasValue) {
+      queries = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--pieces") == 0 && hasValue) {
+      pieces = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+      options.height = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+      options.numThreads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      firstSeed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--queries N] [--pieces N] [--height H] [--threads N]"
+                   " [--seed S] [--verbose]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (queries <= 0 || pieces <= 0 || pieces > Tetrominos::kMaxPreview ||
+      options.height < 0 || options.height > PerfectClearSolver::kMaxHeight) {
+    std::cerr << "Invalid arguments" << std::endl;
+    return 1;
+  }
+
+  PerfectClearSolver solver(options);
+  Board field;
+  int found = 0;
+  int64_t nodes = 0;
+  double totalMs = 0;
+  double maxMs = 0;
+  for (int q = 0; q < queries; q++) {
+    Tetrominos tetrominos(firstSeed + q, RandomizerMode::Bag, pieces);
+    std::vector<int> queue;
+    for (int i = 0; i < pieces; i++) {
+      queue.push_back(tetrominos.peek(i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    PerfectClearResult result = solver.solve(field, queue);
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    found += result.found;
+    nodes += result.nodes;
+    totalMs += ms;
+    maxMs = std::max(maxMs, ms);
+    if (verbose) {
+      std::cout << "Seed " << firstSeed + q << ": "
+                << (result.found ? "found" : "none") << ", height "
+                << result.height << ", " << result.nodes << " nodes, " << ms
+                << " ms" << std::endl;
+    }
+  }
+  std::cout << "Queries:  " << queries << " (" << found << " solvable)"
+            << std::endl;
+  std::cout << "Nodes:    " << nodes << std::endl;
+  std::cout << "Time:     " << totalMs / queries << " ms average, " << maxMs
+            << " ms max" << std::endl;
+  return 0;
+}
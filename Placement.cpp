@@ -0,0 +1,226 @@
+#include "Placement.h"
+#include <algorithm>
+
+template <class B>
+BasicPlacementGenerator<B>::BasicPlacementGenerator()
+    : field_(nullptr), start_(PIECE_I) {
+  placements_.reserve(kNumStates);
+  path_.reserve(kNumStates);
+}
+
+template <class B>
+bool BasicPlacementGenerator<B>::isReachable(int rot, int row, int col) const {
+  return field_ != nullptr && row >= start_.getPosition().first &&
+         row < B::kHeight && ((reachable_[rot][row] >> col) & 1);
+}
+
+template <class B>
+const std::vector<Tetromino> &
+BasicPlacementGenerator<B>::generate(const B &field, const Tetromino &start) {
+  field_ = &field;
+  start_ = start;
+  placements_.clear();
+  if (!Tetromino(start).move(0, 0, field)) {
+    field_ = nullptr;
+    return placements_;
+  }
+
+  // Für jede Rotation und Zeile die Spalten, an denen der Stein passt: Eine
+  // Spalte ist blockiert, wenn eine Zelle des Steins dort auf eine belegte
+  // Zelle fällt, d.h. wenn die Feldzeile um die Spalte der Zelle nach rechts
+  // verschoben an dieser Stelle belegt ist.
+  using Row = typename B::Row;
+  const PieceType &type = PIECES[start.getPiece()];
+  const int numRotations = type.numRotations;
+  const auto &rows = field.getRows();
+  // Über der obersten belegten Zeile passt der Stein überall.
+  int top = 0;
+  while (top < B::kHeight && rows[top] == 0) {
+    top++;
+  }
+  for (int rot = 0; rot < numRotations; rot++) {
+    const PieceRotation &shape = type.rotations[rot];
+    // Die Spalten, an denen die linke obere Ecke stehen kann.
+    const Row columns = B::kFullRow >> (shape.width - 1);
+    for (int row = 0; row <= B::kHeight; row++) {
+      if (row + shape.height > B::kHeight) {
+        valid_[rot][row] = 0;
+        continue;
+      }
+      if (row + shape.height <= top) {
+        valid_[rot][row] = columns;
+        continue;
+      }
+      Row blocked = 0;
+      for (int i = 0; i < shape.height; i++) {
+        for (int j = 0; j < shape.width; j++) {
+          if ((shape.rows[i] >> j) & 1) {
+            blocked |= rows[row + i] >> j;
+          }
+        }
+      }
+      valid_[rot][row] = ~blocked & columns;
+    }
+  }
+
+  // Zeile für Zeile von oben nach unten: Was von oben herunterfallen kann,
+  // wird durch seitliches Schieben und Drehen erweitert, bis sich in der
+  // Zeile nichts mehr ändert. Nach oben geht keine Bewegung, daher reicht ein
+  // Durchgang.
+  auto [startRow, startCol] = start.getPosition();
+  for (int row = 0; row < B::kHeight; row++) {
+    // Passt der Stein in jeder Rotation genau dort, wo er in der Zeile darüber
+    // passt (z.B. überall über dem Stapel), kann er genau dieselben Spalten
+    // erreichen, Schieben und Drehen bringt nichts Neues.
+    bool sameAsAbove = row > startRow;
+    for (int rot = 0; rot < numRotations && sameAsAbove; rot++) {
+      sameAsAbove = valid_[rot][row] == valid_[rot][row - 1];
+    }
+    if (sameAsAbove) {
+      for (int rot = 0; rot < numRotations; rot++) {
+        reachable_[rot][row] = reachable_[rot][row - 1];
+      }
+      continue;
+    }
+    for (int rot = 0; rot < numRotations; rot++) {
+      reachable_[rot][row] =
+          row > startRow ? reachable_[rot][row - 1] & valid_[rot][row] : 0;
+    }
+    if (row == startRow) {
+      reachable_[start.getRotation()][row] = Row{1} << startCol;
+    }
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int rot = 0; rot < numRotations; rot++) {
+        Row reach = reachable_[rot][row];
+        Row valid = valid_[rot][row];
+        Row spread = reach;
+        do {
+          reach = spread;
+          spread = reach | (((reach << 1) | (reach >> 1)) & valid);
+        } while (spread != reach);
+        reachable_[rot][row] = reach;
+        for (int other : {(rot + 1) % numRotations,
+                          (rot + numRotations - 1) % numRotations}) {
+          Row rotated = reach & valid_[other][row];
+          if (rotated & ~reachable_[other][row]) {
+            reachable_[other][row] |= rotated;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  // Endpositionen sind erreichbare Positionen, unter denen kein Platz ist.
+  for (int rot = 0; rot < numRotations; rot++) {
+    for (int row = 0; row < B::kHeight; row++) {
+      Row final = reachable_[rot][row] & ~valid_[rot][row + 1];
+      while (final) {
+        int col = __builtin_ctzll(final);
+        final &= final - 1;
+        placements_.emplace_back(start.getPiece(), rot, row, col);
+      }
+    }
+  }
+  return placements_;
+}
+
+template <class B>
+const std::vector<Action> &
+BasicPlacementGenerator<B>::pathTo(const Tetromino &target) {
+  path_.clear();
+  auto [row, col] = target.getPosition();
+  int rot = target.getRotation();
+  if (target.getPiece() != start_.getPiece() || !isReachable(rot, row, col)) {
+    return path_;
+  }
+
+  // Rückwärts vom Ziel zum Start, mit den Mengen aus `generate`: Konnte der
+  // Stein von oben in den Zustand fallen, war die letzte Eingabe ein Soft
+  // Drop. Sonst wird innerhalb der Zeile (höchstens 4 * kWidth Zustände)
+  // rückwärts nach einem Zustand gesucht, in den er von oben gefallen ist oder
+  // der der Start ist. Schieben und Drehen zwischen gültigen Positionen lässt
+  // sich immer umkehren.
+  const int numRotations = PIECES[start_.getPiece()].numRotations;
+  auto [startRow, startCol] = start_.getPosition();
+  const int startRot = start_.getRotation();
+  auto isEntry = [&](int r, int c) {
+    return (row == startRow && r == startRot && c == startCol) ||
+           isReachable(r, row - 1, c);
+  };
+  // Das letzte Stück fällt der Stein gerade nach unten, das erledigt ein
+  // einziger Hard Drop.
+  path_.push_back(Action::HardDrop);
+  while (isReachable(rot, row - 1, col)) {
+    row--;
+  }
+  while (row != startRow || rot != startRot || col != startCol) {
+    if (isReachable(rot, row - 1, col)) {
+      path_.push_back(Action::SoftDrop);
+      row--;
+      continue;
+    }
+    int16_t next[4][B::kWidth];
+    Action via[4][B::kWidth];
+    bool visited[4][B::kWidth] = {};
+    int queue[4 * B::kWidth];
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = rot * B::kWidth + col;
+    visited[rot][col] = true;
+    int entry = -1;
+    while (entry < 0 && head < tail) {
+      int r = queue[head] / B::kWidth;
+      int c = queue[head] % B::kWidth;
+      head++;
+      if (isEntry(r, c)) {
+        entry = r * B::kWidth + c;
+        break;
+      }
+      // Zustände, von denen aus eine Eingabe nach (r, c) führt.
+      const std::pair<int, int> from[4] = {
+          {r, c - 1},
+          {r, c + 1},
+          {(r + numRotations - 1) % numRotations, c},
+          {(r + 1) % numRotations, c}};
+      const Action action[4] = {Action::Right, Action::Left,
+                                Action::RotateClockwise,
+                                Action::RotateCounterClockwise};
+      for (int k = 0; k < 4; k++) {
+        auto [fr, fc] = from[k];
+        if (fc >= 0 && fc < B::kWidth && !visited[fr][fc] &&
+            isReachable(fr, row, fc)) {
+          visited[fr][fc] = true;
+          next[fr][fc] = r * B::kWidth + c;
+          via[fr][fc] = action[k];
+          queue[tail++] = fr * B::kWidth + fc;
+        }
+      }
+    }
+    if (entry < 0) {
+      path_.clear();
+      return path_;
+    }
+    // Die Eingaben vom Eintrittspunkt bis (rot, col) in umgekehrter Reihenfolge
+    // anhängen.
+    size_t end = path_.size();
+    for (int s = entry; s != rot * B::kWidth + col;) {
+      int r = s / B::kWidth;
+      int c = s % B::kWidth;
+      path_.push_back(via[r][c]);
+      s = next[r][c];
+    }
+    std::reverse(path_.begin() + end, path_.end());
+    rot = entry / B::kWidth;
+    col = entry % B::kWidth;
+  }
+  std::reverse(path_.begin(), path_.end());
+  return path_;
+}
+
+template class BasicPlacementGenerator<Board>;
+template class BasicPlacementGenerator<TallBoard>;
+template class BasicPlacementGenerator<WideBoard>;
+template class BasicPlacementGenerator<HugeBoard>;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Board.h"
+#include "Game.h"
+#include "Tetromino.h"
+#include <cstdint>
+#include <vector>
+
+// Findet alle Endpositionen, die ein Stein von seiner aktuellen Position aus
+// mit den echten Bewegungen (`Tetromino::move`, `rotateClockwise`,
+// `rotateCounterClockwise`) erreichen kann, und die Eingaben dorthin. Alle
+// Puffer werden wiederverwendet, nach dem ersten Aufruf wird also nichts mehr
+// allokiert. Wie `BasicGameState` für alle Größen aus Board.h instanziiert.
+template <class B> class BasicPlacementGenerator {
+public:
+  BasicPlacementGenerator();
+
+  // Alle Endpositionen, d.h. Positionen, von denen aus der Stein nicht weiter
+  // nach unten kann. Die Referenz ist bis zum nächsten Aufruf gültig.
+  const std::vector<Tetromino> &generate(const B &field,
+                                         const Tetromino &start);
+
+  // Die Eingaben, die vom Start des letzten `generate` zu `target` führen,
+  // inklusive des abschließenden Hard Drops, der den Stein festsetzt. Ist
+  // `target` nicht erreichbar, ist das Ergebnis leer.
+  const std::vector<Action> &pathTo(const Tetromino &target);
+
+private:
+  static constexpr int kNumStates = 4 * B::kHeight * B::kWidth;
+
+  // Ob (rot, row, col) von der Startposition aus erreichbar ist.
+  bool isReachable(int rot, int row, int col) const;
+
+  // Für `generate`: pro Rotation und Zeile die Spalten (als Bitmaske), an
+  // denen der Stein ins Feld passt bzw. die er erreichen kann. Die Suche über
+  // (Rotation, Zeile, Spalte) läuft so für alle Spalten einer Zeile
+  // gleichzeitig, jeder Zustand wird genau einmal erreicht.
+  typename B::Row valid_[4][B::kHeight + 1];
+  typename B::Row reachable_[4][B::kHeight];
+  std::vector<Tetromino> placements_;
+
+  // Für `pathTo`: Startposition des letzten `generate` (bzw. kein Feld, wenn
+  // der Start ungültig war).
+  const B *field_;
+  Tetromino start_;
+  std::vector<Action> path_;
+};
+
+using PlacementGenerator = BasicPlacementGenerator<Board>;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Kleiner, schneller Zufallsgenerator (xoshiro256**), dessen Zustand ganz in
+// der Instanz liegt. Gleicher Seed heißt auf jeder Plattform bitgenau gleiche
+// Folge, im Gegensatz zu `std::rand` oder den Verteilungen der
+// Standardbibliothek.
+class Random {
+public:
+  explicit Random(uint64_t seed) {
+    // Den Zustand mit splitmix64 aus dem Seed füllen, wie empfohlen.
+    for (uint64_t &word : state_) {
+      seed += 0x9e3779b97f4a7c15;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  // Die nächsten 64 zufälligen Bits.
+  uint64_t next() {
+    const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  // Eine Zahl in [0, n) für kleine n, ohne Division.
+  int below(int n) { return ((next() >> 32) * n) >> 32; }
+
+private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+  uint64_t state_[4];
+};
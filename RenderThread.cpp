@@ -0,0 +1,58 @@
+#include "./RenderThread.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+RenderThread::RenderThread(TerminalManager &terminal)
+    : terminal_(terminal), wakeFd_(eventfd(0, EFD_CLOEXEC)),
+      stopRequested_(false), framesDrawn_(0), framesSkipped_(0),
+      framesDropped_(0) {
+  if (wakeFd_ < 0) {
+    throw std::runtime_error(std::string("eventfd: ") + std::strerror(errno));
+  }
+  thread_ = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread() {
+  stopRequested_ = true;
+  uint64_t one = 1;
+  if (write(wakeFd_, &one, sizeof(one)) < 0) {
+    // Der Thread merkt das Ende spätestens beim nächsten Bild.
+  }
+  thread_.join();
+  close(wakeFd_);
+}
+
+void RenderThread::publish(const FrameSnapshot &snapshot) {
+  if (!queue_.tryPush(snapshot)) {
+    framesDropped_++;
+    return;
+  }
+  uint64_t one = 1;
+  if (write(wakeFd_, &one, sizeof(one)) < 0) {
+    // Der Zähler des eventfd kann nicht überlaufen, der Thread wacht also
+    // sowieso auf.
+  }
+}
+
+void RenderThread::run() {
+  for (;;) {
+    // Schlafen, bis `publish` oder der Destruktor weckt.
+    uint64_t count;
+    while (read(wakeFd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    // Nur das neueste Bild zeichnen, alle älteren sind schon überholt.
+    framesSkipped_ += queue_.skipToLatest();
+    if (queue_.tryPop(current_)) {
+      if (view_.draw(terminal_, current_)) {
+        framesDrawn_++;
+      }
+    }
+    if (stopRequested_) {
+      return;
+    }
+  }
+}
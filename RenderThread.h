@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SpscQueue.h"
+#include "TerminalManager.h"
+#include "Tetris.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// Zeichnet in einem eigenen Thread, damit ein langsames Terminal (z.B. über
+// ssh) die Spiellogik nicht aufhält. Die Hauptschleife übergibt mit `publish`
+// Kopien des Spielzustands über eine lock-freie Warteschlange, der Thread
+// zeichnet immer nur das neueste Bild und überspringt, was inzwischen veraltet
+// ist. Der Thread ruft nur die Zeichenfunktionen des `TerminalManager` auf,
+// die Hauptschleife weiterhin nur die für Eingaben.
+class RenderThread {
+public:
+  explicit RenderThread(TerminalManager &terminal);
+  // Zeichnet noch das zuletzt übergebene Bild und beendet den Thread.
+  ~RenderThread();
+  RenderThread(const RenderThread &) = delete;
+  RenderThread &operator=(const RenderThread &) = delete;
+
+  // Übergibt ein Bild. Blockiert nie: Ist die Warteschlange voll, weil der
+  // Thread am Terminal hängt, wird das Bild verworfen.
+  void publish(const FrameSnapshot &snapshot);
+
+  // Gezeichnete, übersprungene (vom Thread) und verworfene (von `publish`)
+  // Bilder.
+  int64_t framesDrawn() const { return framesDrawn_; }
+  int64_t framesSkipped() const { return framesSkipped_; }
+  int64_t framesDropped() const { return framesDropped_; }
+
+private:
+  void run();
+
+  TerminalManager &terminal_;
+  GameView view_;
+  SpscQueue<FrameSnapshot, 4> queue_;
+  // Weckt den Thread, wenn etwas in der Warteschlange ist (eventfd).
+  int wakeFd_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<int64_t> framesDrawn_;
+  std::atomic<int64_t> framesSkipped_;
+  std::atomic<int64_t> framesDropped_;
+  // Nur vom Thread benutzt, wegen der Größe nicht auf dem Stack.
+  FrameSnapshot current_;
+  std::thread thread_;
+};
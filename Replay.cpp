@@ -0,0 +1,210 @@
+#include "Replay.h"
+#include "TrainingExport.h"
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char REPLAY_MAGIC[4] = {'T', 'T', 'R', 'P'};
+static const size_t REPLAY_HEADER_SIZE = 16;
+static const size_t REPLAY_BUFFER_SIZE = 4096;
+
+ReplayWriter::ReplayWriter(const std::string &path, uint64_t seed,
+                           const GameState &state)
+    : file_(std::fopen(path.c_str(), "wb")), lastFrame_(state.frame) {
+  if (file_ == nullptr) {
+    throw std::runtime_error("Could not open replay file " + path);
+  }
+  buffer_.reserve(REPLAY_BUFFER_SIZE * 2);
+  buffer_.insert(buffer_.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+  buffer_.push_back(REPLAY_VERSION);
+  buffer_.push_back(static_cast<uint8_t>(state.tetrominos.getMode()));
+  buffer_.push_back(state.tetrominos.previewSize());
+  buffer_.push_back(0);
+  for (int i = 0; i < 8; i++) {
+    buffer_.push_back(seed >> (8 * i));
+  }
+  flush();
+}
+
+ReplayWriter::~ReplayWriter() {
+  if (file_ != nullptr) {
+    try {
+      flush();
+    } catch (const std::exception &) {
+      // Wer den Fehler sehen will, ruft `finish` selbst auf.
+    }
+    std::fclose(file_);
+  }
+}
+
+void ReplayWriter::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    buffer_.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  buffer_.push_back(value);
+}
+
+void ReplayWriter::record(int64_t frame, Action action) {
+  if (file_ == nullptr || action == Action::None) {
+    return;
+  }
+  writeVarint((static_cast<uint64_t>(frame - lastFrame_) << 3) |
+              static_cast<uint8_t>(action));
+  lastFrame_ = frame;
+  if (buffer_.size() >= REPLAY_BUFFER_SIZE) {
+    flush();
+  }
+}
+
+void ReplayWriter::finish(const GameState &state) {
+  if (file_ == nullptr) {
+    return;
+  }
+  writeVarint(static_cast<uint64_t>(state.frame - lastFrame_) << 3);
+  writeVarint(state.piecesPlaced);
+  writeVarint(state.totalLinesCleared);
+  writeVarint(state.level);
+  flush();
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+void ReplayWriter::flush() {
+  if (file_ == nullptr || buffer_.empty()) {
+    return;
+  }
+  if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+    throw std::runtime_error("Could not write replay file");
+  }
+  std::fflush(file_);
+  buffer_.clear();
+}
+
+ReplayReader::ReplayReader(const std::string &path)
+    : data_(nullptr), size_(0), position_(REPLAY_HEADER_SIZE), frame_(0),
+      complete_(false) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open replay file " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < REPLAY_HEADER_SIZE) {
+    close(fd);
+    throw std::runtime_error("Replay file too short: " + path);
+  }
+  size_ = info.st_size;
+  void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("Could not map replay file " + path);
+  }
+  madvise(mapped, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8_t *>(mapped);
+
+  if (std::memcmp(data_, REPLAY_MAGIC, 4) != 0 ||
+      data_[4] != REPLAY_VERSION ||
+      data_[5] > static_cast<uint8_t>(RandomizerMode::Bag)) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    throw std::runtime_error("Not a replay file of version " +
+                             std::to_string(REPLAY_VERSION) + ": " + path);
+  }
+  mode_ = static_cast<RandomizerMode>(data_[5]);
+  previewSize_ = data_[6];
+  seed_ = 0;
+  for (int i = 0; i < 8; i++) {
+    seed_ |= static_cast<uint64_t>(data_[8 + i]) << (8 * i);
+  }
+}
+
+ReplayReader::~ReplayReader() { munmap(const_cast<uint8_t *>(data_), size_); }
+
+bool ReplayReader::readVarint(uint64_t &value) {
+  value = 0;
+  for (int shift = 0; position_ < size_ && shift < 64; shift += 7) {
+    uint8_t byte = data_[position_++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ReplayReader::nextEvent(ReplayEvent &event) {
+  uint64_t value;
+  if (complete_ || !readVarint(value)) {
+    return false;
+  }
+  frame_ += value >> 3;
+  if ((value & 7) == 0) {
+    uint64_t pieces, lines, level;
+    if (readVarint(pieces) && readVarint(lines) && readVarint(level)) {
+      complete_ = true;
+      recorded_.frames = frame_;
+      recorded_.piecesPlaced = pieces;
+      recorded_.linesCleared = lines;
+      recorded_.level = level;
+    }
+    return false;
+  }
+  event.frame = frame_;
+  event.action = static_cast<Action>(value & 7);
+  return true;
+}
+
+void ReplayReader::rewind() {
+  position_ = REPLAY_HEADER_SIZE;
+  frame_ = 0;
+  complete_ = false;
+  recorded_ = ReplayOutcome();
+}
+
+ReplayOutcome simulateReplay(ReplayReader &reader, GameState *finalState,
+                             DecisionLog *log) {
+  reader.rewind();
+  GameState state = reader.initialState();
+  if (log != nullptr) {
+    log->begin(state);
+  }
+  auto observe = [&]() {
+    if (log != nullptr) {
+      log->observe(state);
+    }
+  };
+  ReplayEvent event;
+  bool hasEvent = reader.nextEvent(event);
+  while (hasEvent && !state.gameOver) {
+    while (state.frame < event.frame && !state.gameOver) {
+      step(state, Action::None);
+      observe();
+    }
+    applyAction(state, event.action);
+    observe();
+    hasEvent = reader.nextEvent(event);
+  }
+  // Bis zum aufgezeichneten Ende weiterlaufen lassen (z.B. wenn das Spiel
+  // abgebrochen wurde, während ein Stein fiel). Eingaben im letzten Frame
+  // können auch ohne folgenden Frame aufgezeichnet sein (Escape direkt nach
+  // einer Taste).
+  while (reader.isComplete() &&
+         state.frame < reader.recordedOutcome().frames && !state.gameOver) {
+    step(state, Action::None);
+    observe();
+  }
+
+  ReplayOutcome outcome;
+  outcome.frames = state.frame;
+  outcome.piecesPlaced = state.piecesPlaced;
+  outcome.linesCleared = state.totalLinesCleared;
+  outcome.level = state.level;
+  outcome.gameOver = state.gameOver;
+  if (finalState != nullptr) {
+    *finalState = state;
+  }
+  return outcome;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Game.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Aufzeichnung eines Spiels: Seed und Einstellungen des Zufallsgenerators
+// plus die Eingaben pro Frame. Das Spiel ist damit bitgenau reproduzierbar.
+//
+// Format (alle Zahlen little-endian):
+//   Header, 16 Bytes: "TTRP", Version (1 Byte), RandomizerMode (1 Byte),
+//   Vorschaugröße (1 Byte), 0 (1 Byte), Seed (8 Bytes).
+//   Danach Ereignisse als LEB128-Varint `(frameDelta << 3) | action`, wobei
+//   `frameDelta` die Anzahl Frames seit dem vorigen Ereignis ist (0 für
+//   mehrere Eingaben im selben Frame).
+//   Ein Ereignis mit `action == 0` (Action::None) beendet die Aufzeichnung.
+//   Ihm folgen als Varints die Anzahl der gesetzten Steine, der entfernten
+//   Zeilen und das Level am Ende, zum Vergleich beim Nachspielen.
+//
+// Beim Nachspielen werden in jedem Frame erst alle Eingaben dieses Frames mit
+// `applyAction` ausgeführt und dann `step(state, Action::None)` aufgerufen.
+
+const uint8_t REPLAY_VERSION = 1;
+
+// Schreibt eine Aufzeichnung, während das Spiel läuft.
+class ReplayWriter {
+public:
+  // Öffnet die Datei und schreibt den Header für `state` (das noch keinen
+  // Frame simuliert haben darf). Wirft bei Fehlern eine Exception.
+  ReplayWriter(const std::string &path, uint64_t seed, const GameState &state);
+  ~ReplayWriter();
+  ReplayWriter(const ReplayWriter &) = delete;
+  ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+  // Zeichnet eine Eingabe auf, die im Frame `frame` (Wert von `state.frame`
+  // vor dem `step`) ausgeführt wurde.
+  void record(int64_t frame, Action action);
+
+  // Schreibt das Endereignis mit dem Ergebnis von `state` und schließt die
+  // Datei. Danach wird nichts mehr aufgezeichnet.
+  void finish(const GameState &state);
+
+  // Schreibt den Puffer in die Datei, damit bei einem Absturz höchstens die
+  // Eingaben seit dem letzten Aufruf fehlen.
+  void flush();
+
+private:
+  void writeVarint(uint64_t value);
+
+  std::FILE *file_;
+  std::vector<uint8_t> buffer_;
+  int64_t lastFrame_;
+};
+
+// Ein Ereignis der Aufzeichnung.
+struct ReplayEvent {
+  int64_t frame;
+  Action action;
+};
+
+// Das Ergebnis eines Spiels, wie es am Ende der Aufzeichnung steht bzw. beim
+// Nachspielen herauskommt.
+struct ReplayOutcome {
+  int64_t frames = 0;
+  int piecesPlaced = 0;
+  int linesCleared = 0;
+  int level = 0;
+  bool gameOver = false;
+
+  // Vergleicht nur, was in der Datei steht (nicht `gameOver`).
+  bool matches(const ReplayOutcome &other) const {
+    return frames == other.frames && piecesPlaced == other.piecesPlaced &&
+           linesCleared == other.linesCleared && level == other.level;
+  }
+};
+
+// Liest eine Aufzeichnung per mmap, ohne sie zu kopieren. Wirft bei Fehlern
+// eine Exception.
+class ReplayReader {
+public:
+  explicit ReplayReader(const std::string &path);
+  ~ReplayReader();
+  ReplayReader(const ReplayReader &) = delete;
+  ReplayReader &operator=(const ReplayReader &) = delete;
+
+  uint64_t seed() const { return seed_; }
+  RandomizerMode mode() const { return mode_; }
+  int previewSize() const { return previewSize_; }
+
+  // Das neue Spiel, mit dem die Aufzeichnung beginnt.
+  GameState initialState() const {
+    return GameState(seed_, mode_, previewSize_);
+  }
+
+  // Iteriert über die Ereignisse: liefert false am Ende. Nach dem Ende steht
+  // das aufgezeichnete Ergebnis in `recordedOutcome` (falls die Aufzeichnung
+  // vollständig war, siehe `isComplete`).
+  bool nextEvent(ReplayEvent &event);
+  void rewind();
+  bool isComplete() const { return complete_; }
+  const ReplayOutcome &recordedOutcome() const { return recorded_; }
+
+private:
+  bool readVarint(uint64_t &value);
+
+  const uint8_t *data_;
+  size_t size_;
+  size_t position_;
+  int64_t frame_;
+  uint64_t seed_;
+  RandomizerMode mode_;
+  int previewSize_;
+  bool complete_;
+  ReplayOutcome recorded_;
+};
+
+class DecisionLog;
+
+// Spielt eine Aufzeichnung ohne Terminal nach und gibt das Ergebnis zurück.
+// `finalState` bekommt, falls gegeben, den Zustand am Ende, `log` jeden
+// Zwischenstand (für den Export von Trainingsdaten).
+ReplayOutcome simulateReplay(ReplayReader &reader,
+                             GameState *finalState = nullptr,
+                             DecisionLog *log = nullptr);
@@ -0,0 +1,72 @@
+#include "./Replay.h"
+#include "./TrainingExport.h"
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+
+// Spielt Aufzeichnungen ohne Terminal nach und prüft, ob dasselbe Ergebnis
+// herauskommt wie beim Aufzeichnen. Der Exit-Code ist 1, wenn eine
+// Aufzeichnung nicht passt oder nicht gelesen werden kann. Mit `--export FILE`
+// landen alle Entscheidungen aus allen Aufzeichnungen als Trainingsdaten in
+// FILE.
+int main(int argc, char **argv) {
+  int first = 1;
+  std::unique_ptr<TrainingWriter> writer;
+  std::unique_ptr<DecisionLog> log;
+  if (argc > 2 && std::strcmp(argv[1], "--export") == 0) {
+    try {
+      writer = std::make_unique<TrainingWriter>(argv[2]);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    log = std::make_unique<DecisionLog>(*writer);
+    first = 3;
+  }
+  if (first >= argc) {
+    std::cerr << "Usage: " << argv[0] << " [--export FILE] REPLAY_FILE..."
+              << std::endl;
+    return 1;
+  }
+  bool allMatch = true;
+  for (int i = first; i < argc; i++) {
+    try {
+      ReplayReader reader(argv[i]);
+      auto start = std::chrono::steady_clock::now();
+      ReplayOutcome outcome = simulateReplay(reader, nullptr, log.get());
+      double seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      bool ok = reader.isComplete() &&
+                outcome.matches(reader.recordedOutcome());
+      allMatch &= ok;
+      std::cout << argv[i] << ": seed " << reader.seed() << ", "
+                << outcome.frames << " frames, " << outcome.piecesPlaced
+                << " pieces, " << outcome.linesCleared << " lines, level "
+                << outcome.level << ", "
+                << (seconds > 0 ? outcome.frames / seconds / 1e6 : 0)
+                << "M frames/s: "
+                << (!reader.isComplete() ? "INCOMPLETE"
+                    : ok                 ? "OK"
+                                         : "MISMATCH")
+                << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << argv[i] << ": " << e.what() << std::endl;
+      allMatch = false;
+    }
+  }
+  if (writer != nullptr) {
+    try {
+      log.reset();
+      writer->finish();
+      std::cout << "Exported " << writer->samplesWritten() << " samples, "
+                << writer->bytesWritten() << " bytes" << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      allMatch = false;
+    }
+  }
+  return allMatch ? 0 : 1;
+}
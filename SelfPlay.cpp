@@ -0,0 +1,232 @@
+#include "SelfPlay.h"
+#include "TrainingExport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+void WorkQueue::push(int task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tasks_.push_back(task);
+}
+
+bool WorkQueue::pop(int &task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tasks_.empty()) {
+    return false;
+  }
+  task = tasks_.back();
+  tasks_.pop_back();
+  return true;
+}
+
+bool WorkQueue::steal(int &task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tasks_.empty()) {
+    return false;
+  }
+  task = tasks_.front();
+  tasks_.pop_front();
+  return true;
+}
+
+template <class B>
+void playGreedyGame(BasicGameState<B> &state, const BotWeights &weights,
+                    int maxPieces, int64_t &evaluated) {
+  BasicPlacementGenerator<B> generator;
+  while (!state.gameOver && state.piecesPlaced < maxPieces) {
+    const std::vector<Tetromino> &placements =
+        generator.generate(state.field, state.currentTetromino);
+    evaluated += placements.size();
+    const Tetromino *best = nullptr;
+    double bestScore = 0;
+    for (const Tetromino &placement : placements) {
+      double score = evaluatePlacement(weights, state.field, placement);
+      if (best == nullptr || score > bestScore) {
+        best = &placement;
+        bestScore = score;
+      }
+    }
+    if (best == nullptr) {
+      break;
+    }
+    const std::vector<Action> &path = generator.pathTo(*best);
+    if (path.empty()) {
+      break;
+    }
+    for (Action action : path) {
+      applyAction(state, action);
+    }
+  }
+}
+
+template void playGreedyGame(GameState &, const BotWeights &, int, int64_t &);
+template void playGreedyGame(BasicGameState<TallBoard> &, const BotWeights &,
+                             int, int64_t &);
+template void playGreedyGame(BasicGameState<WideBoard> &, const BotWeights &,
+                             int, int64_t &);
+template void playGreedyGame(BasicGameState<HugeBoard> &, const BotWeights &,
+                             int, int64_t &);
+
+namespace {
+template <class B> bool isBoard(const SelfPlayOptions &options) {
+  return options.boardWidth == B::kWidth && options.boardHeight == B::kHeight;
+}
+
+template <class B>
+void storeResult(const BasicGameState<B> &state, GameResult &result) {
+  result.linesCleared = state.totalLinesCleared;
+  result.level = state.level;
+  result.piecesPlaced = state.piecesPlaced;
+  result.gameOver = state.gameOver;
+}
+
+// Spiel `result.seed` auf einem größeren Feld (siehe `playGreedyGame`).
+template <class B>
+void playLargeGame(const SelfPlayOptions &options, GameResult &result,
+                   int64_t &evaluated) {
+  BasicGameState<B> state(result.seed, options.randomizer);
+  playGreedyGame(state, options.weights, options.maxPieces, evaluated);
+  storeResult(state, result);
+}
+
+// Wie `playGame`, meldet aber jede Eingabe an `log`.
+void playLoggedGame(GameState &state, Bot &bot, int maxPieces,
+                    DecisionLog &log) {
+  log.begin(state);
+  while (!state.gameOver && state.piecesPlaced < maxPieces) {
+    const std::vector<Action> &path = bot.planMoves(state);
+    if (path.empty()) {
+      break;
+    }
+    for (Action action : path) {
+      applyAction(state, action);
+      log.observe(state);
+    }
+  }
+}
+} // namespace
+
+SelfPlayStats runSelfPlay(const SelfPlayOptions &options,
+                          std::vector<GameResult> *results) {
+  SelfPlayStats stats;
+  stats.numGames = options.numGames;
+  stats.numThreads = options.numThreads > 0
+                         ? options.numThreads
+                         : std::max(1u, std::thread::hardware_concurrency());
+  const int numThreads = stats.numThreads;
+  void (*playLarge)(const SelfPlayOptions &, GameResult &, int64_t &) = nullptr;
+  if (isBoard<TallBoard>(options)) {
+    playLarge = playLargeGame<TallBoard>;
+  } else if (isBoard<WideBoard>(options)) {
+    playLarge = playLargeGame<WideBoard>;
+  } else if (isBoard<HugeBoard>(options)) {
+    playLarge = playLargeGame<HugeBoard>;
+  } else if (!isBoard<Board>(options)) {
+    throw std::runtime_error("No board of size " +
+                             std::to_string(options.boardWidth) + "x" +
+                             std::to_string(options.boardHeight) +
+                             " (10x20, 16x40, 32x32 or 64x64)");
+  }
+  if (playLarge != nullptr &&
+      (options.lookahead > 0 || !options.exportPath.empty())) {
+    throw std::runtime_error(
+        "Lookahead and export only work on the standard board");
+  }
+
+  // Jeder Thread bekommt einen zusammenhängenden Block von Spielen. Dauern
+  // seine Spiele kürzer als die der anderen, stiehlt er danach bei ihnen.
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  for (int t = 0; t < numThreads; t++) {
+    queues.push_back(std::make_unique<WorkQueue>());
+  }
+  for (int i = options.numGames - 1; i >= 0; i--) {
+    queues[static_cast<int64_t>(i) * numThreads / options.numGames]->push(i);
+  }
+
+  std::vector<GameResult> gameResults(options.numGames);
+  std::atomic<int64_t> placementsEvaluated(0);
+  std::atomic<int64_t> gamesStolen(0);
+  std::atomic<int64_t> tableHits(0);
+  std::unique_ptr<TranspositionTable> table;
+  if (options.lookahead > 0 && options.tableLog2Entries > 0) {
+    table = std::make_unique<TranspositionTable>(options.tableLog2Entries);
+  }
+  std::unique_ptr<TrainingWriter> writer;
+  if (!options.exportPath.empty()) {
+    writer = std::make_unique<TrainingWriter>(options.exportPath);
+  }
+  auto worker = [&](int self) {
+    int64_t evaluated = 0;
+    Bot bot(options.weights, options.lookahead, table.get());
+    std::unique_ptr<DecisionLog> log;
+    if (writer != nullptr) {
+      log = std::make_unique<DecisionLog>(*writer);
+    }
+    int64_t stolen = 0;
+    int task;
+    while (true) {
+      if (!queues[self]->pop(task)) {
+        bool found = false;
+        for (int k = 1; k < numThreads && !found; k++) {
+          found = queues[(self + k) % numThreads]->steal(task);
+        }
+        if (!found) {
+          break;
+        }
+        stolen++;
+      }
+      GameResult &result = gameResults[task];
+      result.seed = options.firstSeed + task;
+      if (playLarge != nullptr) {
+        playLarge(options, result, evaluated);
+        continue;
+      }
+      GameState state(result.seed, options.randomizer,
+                      std::max(1, options.lookahead - 1));
+      if (log != nullptr) {
+        playLoggedGame(state, bot, options.maxPieces, *log);
+      } else {
+        playGame(state, bot, options.maxPieces);
+      }
+      storeResult(state, result);
+    }
+    placementsEvaluated += evaluated + bot.placementsEvaluated();
+    tableHits += bot.tableHits();
+    gamesStolen += stolen;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back(worker, t);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  if (writer != nullptr) {
+    writer->finish();
+    stats.samplesExported = writer->samplesWritten();
+    stats.exportStalls = writer->stalls();
+  }
+  stats.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+  for (const GameResult &result : gameResults) {
+    stats.linesCleared += result.linesCleared;
+    stats.piecesPlaced += result.piecesPlaced;
+    stats.maxLevel = std::max(stats.maxLevel, result.level);
+    stats.gamesOver += result.gameOver;
+  }
+  stats.placementsEvaluated = placementsEvaluated;
+  stats.tableHits = tableHits;
+  stats.gamesStolen = gamesStolen;
+  if (results != nullptr) {
+    *results = std::move(gameResults);
+  }
+  return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Bot.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Viele unabhängige Spiele des Bots auf allen Kernen, z.B. um Gewichte zu
+// tunen oder Regeländerungen zu testen. Spiel `i` benutzt den Seed
+// `firstSeed + i`, jeder Lauf ist also reproduzierbar.
+
+struct SelfPlayOptions {
+  int numGames = 1000;
+  uint64_t firstSeed = 1;
+  // 0 heißt: so viele Threads wie Kerne.
+  int numThreads = 0;
+  // Ein Spiel endet spätestens nach so vielen Steinen.
+  int maxPieces = 10000;
+  RandomizerMode randomizer = RandomizerMode::Classic;
+  // Größe des Feldes, eine der Größen aus Board.h. `Bot` gibt es nur für
+  // `Board`, auf den größeren Feldern spielt statt ihm `playGreedyGame` mit
+  // denselben Gewichten, ohne Vorausschau und ohne Export.
+  int boardWidth = Board::kWidth;
+  int boardHeight = Board::kHeight;
+  BotWeights weights;
+  // Vorausschau des Bots in Steinen (siehe `Bot`). Alle Threads teilen sich
+  // eine Tabelle mit 2^`tableLog2Entries` Einträgen, 0 heißt ohne Tabelle.
+  int lookahead = 0;
+  int tableLog2Entries = 22;
+  // Falls nicht leer: Jede Entscheidung des Bots wird als Trainingsdatensatz
+  // in diese Datei geschrieben (siehe TrainingExport.h).
+  std::string exportPath;
+};
+
+// Ergebnis eines einzelnen Spiels.
+struct GameResult {
+  uint64_t seed = 0;
+  int linesCleared = 0;
+  int level = 0;
+  int piecesPlaced = 0;
+  bool gameOver = false;
+};
+
+// Zusammenfassung eines Laufs.
+struct SelfPlayStats {
+  int numGames = 0;
+  int numThreads = 0;
+  int64_t linesCleared = 0;
+  int64_t piecesPlaced = 0;
+  int64_t placementsEvaluated = 0;
+  int64_t tableHits = 0;
+  int maxLevel = 0;
+  int gamesOver = 0;
+  double seconds = 0;
+  // Anzahl der Spiele, die ein anderer als der zugeteilte Thread gespielt
+  // hat.
+  int64_t gamesStolen = 0;
+  // Exportierte Datensätze und wie oft dabei auf die Platte gewartet wurde.
+  int64_t samplesExported = 0;
+  int64_t exportStalls = 0;
+
+  double gamesPerSecond() const { return seconds > 0 ? numGames / seconds : 0; }
+};
+
+// Warteschlange eines Threads für das Work Stealing: Der Besitzer nimmt von
+// hinten, andere Threads stehlen von vorne. Die Aufgaben sind ganze Spiele,
+// der Mutex ist also im Vergleich zur Arbeit billig.
+class WorkQueue {
+public:
+  void push(int task);
+  bool pop(int &task);
+  bool steal(int &task);
+
+private:
+  std::mutex mutex_;
+  std::deque<int> tasks_;
+};
+
+// Spielt ein Spiel auf einem Feld vom Typ `B` wie der Bot ohne Vorausschau:
+// Jeder Stein geht an die Endposition mit dem besten `evaluatePlacement`.
+// Zählt die bewerteten Endpositionen in `evaluated`.
+template <class B>
+void playGreedyGame(BasicGameState<B> &state, const BotWeights &weights,
+                    int maxPieces, int64_t &evaluated);
+
+// Spielt alle Spiele und gibt die Zusammenfassung zurück. Ist `results`
+// gegeben, steht dort danach das Ergebnis von Spiel `i` an Position `i`.
+// Wirft eine Exception bei einer unbekannten Größe des Feldes oder
+// Vorausschau bzw. Export auf einem größeren Feld.
+SelfPlayStats runSelfPlay(const SelfPlayOptions &options,
+                          std::vector<GameResult> *results = nullptr);
@@ -0,0 +1,76 @@
+#include "./SelfPlay.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+// Spielt viele Spiele des Bots parallel ohne Terminal und gibt eine
+// Zusammenfassung aus.
+int main(int argc, char **argv) {
+  SelfPlayOptions options;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--games") == 0 && hasValue) {
+      options.numGames = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+      options.numThreads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      options.firstSeed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--max-pieces") == 0 && hasValue) {
+      options.maxPieces = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--lookahead") == 0 && hasValue) {
+      options.lookahead = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--table-bits") == 0 && hasValue) {
+      options.tableLog2Entries = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--export") == 0 && hasValue) {
+      options.exportPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--board") == 0 && hasValue &&
+               std::sscanf(argv[i + 1], "%dx%d", &options.boardWidth,
+                           &options.boardHeight) == 2) {
+      i++;
+    } else if (std::strcmp(argv[i], "--bag") == 0) {
+      options.randomizer = RandomizerMode::Bag;
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--games N] [--threads N] [--seed S] [--max-pieces N]"
+                   " [--bag] [--board WxH] [--lookahead N]"
+                   " [--table-bits N] [--export FILE]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (options.numGames <= 0) {
+    std::cerr << "Number of games must be positive" << std::endl;
+    return 1;
+  }
+
+  SelfPlayStats stats;
+  try {
+    stats = runSelfPlay(options);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "Games:          " << stats.numGames << " ("
+            << stats.gamesOver << " lost, " << stats.gamesStolen
+            << " stolen)" << std::endl;
+  std::cout << "Threads:        " << stats.numThreads << std::endl;
+  std::cout << "Lines:          " << stats.linesCleared << " ("
+            << static_cast<double>(stats.linesCleared) / stats.numGames
+            << " per game)" << std::endl;
+  std::cout << "Max level:      " << stats.maxLevel << std::endl;
+  std::cout << "Pieces placed:  " << stats.piecesPlaced << std::endl;
+  std::cout << "Time:           " << stats.seconds << " s" << std::endl;
+  std::cout << "Games/sec:      " << stats.gamesPerSecond() << std::endl;
+  std::cout << "Placements/sec: " << stats.placementsEvaluated / stats.seconds
+            << std::endl;
+  if (!options.exportPath.empty()) {
+    std::cout << "Exported:       " << stats.samplesExported << " samples ("
+              << stats.exportStalls << " stalls)" << std::endl;
+  }
+  if (options.lookahead > 0) {
+    std::cout << "Table hits:     " << stats.tableHits << std::endl;
+  }
+  return 0;
+}
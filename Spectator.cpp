@@ -0,0 +1,474 @@
+#include "Spectator.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+const int NUM_CELLS = Board::kWidth * Board::kHeight;
+static_assert(NUM_CELLS <= 256, "Zellindex passt nicht in ein Byte");
+// Flags einer Änderung.
+const uint8_t CHANGED_PIECE = 1;
+const uint8_t CHANGED_NEXT = 2;
+const uint8_t CHANGED_NUMBERS = 4;
+
+void appendVarint(std::string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+// Liest einen Varint ab `p`, false wenn er vor `end` nicht vollständig ist.
+bool readVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    uint8_t byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Wie `readVarint` und `*p++`, aber mitten in einer Nachricht: Fehlt etwas,
+// ist die Nachricht ungültig.
+uint64_t takeVarint(const uint8_t *&p, const uint8_t *end) {
+  uint64_t value;
+  if (!readVarint(p, end, value)) {
+    throw std::runtime_error("Truncated spectator message");
+  }
+  return value;
+}
+
+uint8_t takeByte(const uint8_t *&p, const uint8_t *end) {
+  if (p == end) {
+    throw std::runtime_error("Truncated spectator message");
+  }
+  return *p++;
+}
+
+void appendPiece(std::string &out, const Tetromino &piece) {
+  auto [row, col] = piece.getPosition();
+  out += static_cast<char>(piece.getPiece());
+  out += static_cast<char>(piece.getRotation());
+  out += static_cast<char>(row);
+  out += static_cast<char>(col);
+}
+
+Tetromino takePiece(const uint8_t *&p, const uint8_t *end) {
+  int piece = takeByte(p, end);
+  int rotation = takeByte(p, end);
+  int row = static_cast<int8_t>(takeByte(p, end));
+  int col = static_cast<int8_t>(takeByte(p, end));
+  if (piece >= NUM_PIECES || rotation >= PIECES[piece].numRotations) {
+    throw std::runtime_error("Invalid piece in spectator message");
+  }
+  return Tetromino(piece, rotation, row, col);
+}
+
+bool samePiece(const Tetromino &a, const Tetromino &b) {
+  return a.getPiece() == b.getPiece() && a.getRotation() == b.getRotation() &&
+         a.getPosition() == b.getPosition();
+}
+
+void throwSystemError(const char *what) {
+  throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+} // namespace
+
+SpectatorEncoder::SpectatorEncoder(int keyframeInterval)
+    : keyframeInterval_(keyframeInterval), started_(false), lastFrame_(0),
+      lastKeyframe_(0) {}
+
+void SpectatorEncoder::encodeKeyframe(const FrameSnapshot &snapshot,
+                                      std::string &message) {
+  message.clear();
+  message += 'K';
+  appendVarint(message, snapshot.frame);
+  appendVarint(message, snapshot.level);
+  appendVarint(message, snapshot.linesCleared);
+  appendVarint(message, snapshot.score);
+  appendVarint(message, snapshot.piecesPlaced);
+  appendPiece(message, snapshot.current);
+  message += static_cast<char>(snapshot.next.getPiece());
+  const Board &field = snapshot.field;
+  for (int i = 0; i < NUM_CELLS; i += 2) {
+    int j = i + 1;
+    int low = field.getColor(i / Board::kWidth, i % Board::kWidth);
+    int high = field.getColor(j / Board::kWidth, j % Board::kWidth);
+    message += static_cast<char>((low & 0xf) | (high & 0xf) << 4);
+  }
+}
+
+bool SpectatorEncoder::encode(const FrameSnapshot &snapshot,
+                              std::string &out) {
+  bool keyframe =
+      !started_ || snapshot.frame - lastKeyframe_ >= keyframeInterval_;
+  if (!keyframe) {
+    uint8_t flags = 0;
+    if (!samePiece(snapshot.current, shown_.current)) {
+      flags |= CHANGED_PIECE;
+    }
+    if (snapshot.next.getPiece() != shown_.next.getPiece()) {
+      flags |= CHANGED_NEXT;
+    }
+    if (snapshot.level != shown_.level ||
+        snapshot.linesCleared != shown_.linesCleared ||
+        snapshot.score != shown_.score ||
+        snapshot.piecesPlaced != shown_.piecesPlaced) {
+      flags |= CHANGED_NUMBERS;
+    }
+    // Die Zellen kommen ans Ende, gesammelt wird vorher in `cells_`.
+    cells_.clear();
+    int changes = 0;
+    for (int row = 0; row < Board::kHeight; row++) {
+      if (snapshot.field.getRow(row) == 0 && shown_.field.getRow(row) == 0) {
+        continue;
+      }
+      for (int col = 0; col < Board::kWidth; col++) {
+        int color = snapshot.field.getColor(row, col);
+        if (color != shown_.field.getColor(row, col)) {
+          cells_ += static_cast<char>(row * Board::kWidth + col);
+          cells_ += static_cast<char>(color);
+          changes++;
+        }
+      }
+    }
+    if (flags == 0 && changes == 0) {
+      return false;
+    }
+    // Ab etwa einer Viertel geänderter Zellen ist ein Keyframe kürzer.
+    keyframe = 2 * changes > NUM_CELLS / 2;
+    if (!keyframe) {
+      message_.clear();
+      message_ += 'D';
+      appendVarint(message_, snapshot.frame - lastFrame_);
+      message_ += static_cast<char>(flags);
+      if (flags & CHANGED_NUMBERS) {
+        appendVarint(message_, snapshot.level);
+        appendVarint(message_, snapshot.linesCleared);
+        appendVarint(message_, snapshot.score);
+        appendVarint(message_, snapshot.piecesPlaced);
+      }
+      if (flags & CHANGED_PIECE) {
+        appendPiece(message_, snapshot.current);
+      }
+      if (flags & CHANGED_NEXT) {
+        message_ += static_cast<char>(snapshot.next.getPiece());
+      }
+      appendVarint(message_, changes);
+      message_ += cells_;
+    }
+  }
+  if (keyframe) {
+    encodeKeyframe(snapshot, message_);
+    lastKeyframe_ = snapshot.frame;
+  }
+  appendVarint(out, message_.size());
+  out += message_;
+
+  // Nur übernehmen, was auch kodiert wird (nicht den Text).
+  shown_.field = snapshot.field;
+  shown_.current = snapshot.current;
+  shown_.next = snapshot.next;
+  shown_.level = snapshot.level;
+  shown_.linesCleared = snapshot.linesCleared;
+  shown_.score = snapshot.score;
+  shown_.piecesPlaced = snapshot.piecesPlaced;
+  lastFrame_ = snapshot.frame;
+  started_ = true;
+  return keyframe;
+}
+
+size_t SpectatorDecoder::decode(const uint8_t *data, size_t size) {
+  const uint8_t *end = data + size;
+  const uint8_t *p = data;
+  for (;;) {
+    const uint8_t *start = p;
+    uint64_t length;
+    if (!readVarint(p, end, length) ||
+        length > static_cast<uint64_t>(end - p)) {
+      return start - data;
+    }
+    if (length == 0) {
+      throw std::runtime_error("Empty spectator message");
+    }
+    apply(static_cast<char>(*p), p + 1, p + length);
+    p += length;
+  }
+}
+
+void SpectatorDecoder::apply(char type, const uint8_t *p, const uint8_t *end) {
+  FrameSnapshot &s = snapshot_;
+  uint8_t flags;
+  if (type == 'K') {
+    flags = CHANGED_PIECE | CHANGED_NEXT | CHANGED_NUMBERS;
+    s.frame = takeVarint(p, end);
+  } else if (type == 'D') {
+    if (!synced_) {
+      return;
+    }
+    s.frame += takeVarint(p, end);
+    flags = takeByte(p, end);
+  } else {
+    // Unbekannte Nachrichten (aus neueren Versionen) überspringen.
+    return;
+  }
+  if (flags & CHANGED_NUMBERS) {
+    s.level = takeVarint(p, end);
+    s.linesCleared = takeVarint(p, end);
+    s.score = takeVarint(p, end);
+    s.piecesPlaced = takeVarint(p, end);
+  }
+  if (flags & CHANGED_PIECE) {
+    s.current = takePiece(p, end);
+  }
+  if (flags & CHANGED_NEXT) {
+    int next = takeByte(p, end);
+    if (next >= NUM_PIECES) {
+      throw std::runtime_error("Invalid piece in spectator message");
+    }
+    s.next = Tetromino(next);
+  }
+  auto setCell = [&s](int index, int color) {
+    int row = index / Board::kWidth;
+    int col = index % Board::kWidth;
+    if (s.field.getColor(row, col) != color) {
+      s.field.setCell(row, col, color);
+    }
+  };
+  if (type == 'K') {
+    for (int i = 0; i < NUM_CELLS; i += 2) {
+      uint8_t colors = takeByte(p, end);
+      setCell(i, colors & 0xf);
+      setCell(i + 1, colors >> 4);
+    }
+    synced_ = true;
+    keyframes_++;
+    return;
+  }
+  uint64_t changes = takeVarint(p, end);
+  for (uint64_t i = 0; i < changes; i++) {
+    int index = takeByte(p, end);
+    int color = takeByte(p, end);
+    if (index >= NUM_CELLS) {
+      throw std::runtime_error("Invalid cell in spectator message");
+    }
+    setCell(index, color);
+  }
+  deltas_++;
+}
+
+SpectatorServer::SpectatorServer(const SpectatorServerOptions &options)
+    : options_(options), listenFd_(-1), epollFd_(-1), wakeFd_(-1),
+      stopRequested_(false), viewers_(0), bytesSent_(0), resyncs_(0),
+      framesDropped_(0), encoder_(options.keyframeInterval) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (options_.socketPath.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + options_.socketPath);
+  }
+  std::strcpy(address.sun_path, options_.socketPath.c_str());
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0) {
+    throwSystemError("socket");
+  }
+  unlink(options_.socketPath.c_str());
+  if (bind(listenFd_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listenFd_, SOMAXCONN) < 0) {
+    close(listenFd_);
+    throwSystemError(options_.socketPath.c_str());
+  }
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd_ < 0 || wakeFd_ < 0) {
+    // Was schon offen ist, wieder schließen, ohne `errno` zu verlieren.
+    int error = errno;
+    for (int fd : {listenFd_, epollFd_, wakeFd_}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    unlink(options_.socketPath.c_str());
+    errno = error;
+    throwSystemError("epoll/eventfd");
+  }
+  for (int fd : {listenFd_, wakeFd_}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+  }
+  thread_ = std::thread(&SpectatorServer::run, this);
+}
+
+SpectatorServer::~SpectatorServer() {
+  stopRequested_ = true;
+  uint64_t one = 1;
+  if (write(wakeFd_, &one, sizeof(one)) < 0) {
+    // Der eventfd ist nicht blockierend und läuft nicht über.
+  }
+  thread_.join();
+  for (auto &viewer : connections_) {
+    if (viewer) {
+      close(viewer->fd);
+    }
+  }
+  close(wakeFd_);
+  close(epollFd_);
+  close(listenFd_);
+  unlink(options_.socketPath.c_str());
+}
+
+void SpectatorServer::publish(const FrameSnapshot &snapshot) {
+  if (!queue_.tryPush(snapshot)) {
+    framesDropped_++;
+    return;
+  }
+  uint64_t one = 1;
+  if (write(wakeFd_, &one, sizeof(one)) < 0) {
+    // Der Zähler des eventfd kann nicht überlaufen, der Thread wacht also
+    // sowieso auf.
+  }
+}
+
+void SpectatorServer::run() {
+  epoll_event events[64];
+  // Nach `stopRequested_` noch höchstens so viele Runden à 10 ms, um
+  // ausstehende Daten loszuwerden.
+  int finalRounds = 20;
+  for (;;) {
+    bool stopping = stopRequested_;
+    int n = epoll_wait(epollFd_, events, 64, stopping ? 10 : -1);
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+      if (fd == listenFd_) {
+        acceptViewers();
+      } else if (fd == wakeFd_) {
+        uint64_t count;
+        if (read(wakeFd_, &count, sizeof(count)) < 0) {
+          // Schon gelesen, die Warteschlange wird trotzdem geleert.
+        }
+        // Jedes Bild einmal kodieren, für alle Zuschauer dieselben Bytes.
+        while (queue_.tryPop(current_)) {
+          message_.clear();
+          bool keyframe = encoder_.encode(current_, message_);
+          if (!message_.empty()) {
+            broadcast(message_, keyframe);
+          }
+        }
+      } else if (fd < static_cast<int>(connections_.size()) &&
+                 connections_[fd]) {
+        if (events[i].events & EPOLLOUT) {
+          writeViewer(*connections_[fd]);
+        }
+        if (connections_[fd] &&
+            (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+          // Zuschauer schicken nichts, es kann nur das Ende kommen.
+          char buffer[256];
+          ssize_t got = read(fd, buffer, sizeof(buffer));
+          if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+            closeViewer(fd);
+          }
+        }
+      }
+    }
+    if (stopping) {
+      bool pending = false;
+      for (auto &viewer : connections_) {
+        pending |= viewer && !viewer->out.empty();
+      }
+      if (!pending || --finalRounds == 0) {
+        return;
+      }
+    }
+  }
+}
+
+void SpectatorServer::acceptViewers() {
+  for (;;) {
+    int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    if (fd >= static_cast<int>(connections_.size())) {
+      connections_.resize(fd + 1);
+    }
+    connections_[fd] = std::make_unique<Viewer>();
+    connections_[fd]->fd = fd;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    viewers_++;
+  }
+}
+
+void SpectatorServer::broadcast(const std::string &message, bool keyframe) {
+  for (auto &connection : connections_) {
+    if (!connection || (!connection->synced && !keyframe)) {
+      continue;
+    }
+    Viewer &viewer = *connection;
+    // Nur ganze Nachrichten werden weggelassen, der Strom bleibt lesbar.
+    if (!viewer.out.empty() &&
+        viewer.out.size() + message.size() > options_.maxPendingBytes) {
+      if (viewer.synced) {
+        viewer.synced = false;
+        resyncs_++;
+      }
+      continue;
+    }
+    viewer.synced = true;
+    viewer.out += message;
+    if (!viewer.waitingForWrite) {
+      writeViewer(viewer);
+    }
+  }
+}
+
+void SpectatorServer::writeViewer(Viewer &viewer) {
+  size_t sent = 0;
+  while (sent < viewer.out.size()) {
+    // MSG_NOSIGNAL: ein geschlossener Zuschauer soll kein SIGPIPE auslösen.
+    ssize_t n = ::send(viewer.fd, viewer.out.data() + sent,
+                       viewer.out.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && errno != EAGAIN) {
+      closeViewer(viewer.fd);
+      return;
+    }
+    if (n < 0) {
+      break;
+    }
+    sent += n;
+  }
+  viewer.out.erase(0, sent);
+  bytesSent_ += sent;
+  // Auf EPOLLOUT nur warten, solange etwas aussteht.
+  bool wait = !viewer.out.empty();
+  if (wait != viewer.waitingForWrite) {
+    epoll_event event{};
+    event.events = EPOLLIN | (wait ? EPOLLOUT : 0u);
+    event.data.fd = viewer.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, viewer.fd, &event);
+    viewer.waitingForWrite = wait;
+  }
+}
+
+void SpectatorServer::closeViewer(int fd) {
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  connections_[fd].reset();
+  viewers_--;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "SpscQueue.h"
+#include "Tetris.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Zuschauer für ein laufendes Spiel: Das Spiel übergibt jedes Bild an einen
+// `SpectatorServer`, der es kodiert und an alle verbundenen Zuschauer eines
+// Unix-Sockets schickt (siehe SpectatorMain.cpp).
+//
+// Format (Binär, alle Zahlen als LEB128-Varint wie bei Replay.h): Eine Folge
+// von Nachrichten, jede beginnt mit ihrer Länge (ohne die Länge selbst) und
+// einem Typ-Byte.
+//   'K' Keyframe, der komplette Zustand: Frame, Level, Zeilen, Punkte,
+//       gesetzte Steine, dann je ein Byte Stein, Rotation, Zeile, Spalte,
+//       nächster Stein, dann die Farben aller Zellen, zwei pro Byte (die
+//       gerade Zelle im unteren Halbbyte), Zeile für Zeile von oben.
+//   'D' Änderungen seit der vorigen Nachricht: Frames seit der vorigen
+//       Nachricht, ein Byte mit Flags (4 = Zahlen, 1 = Stein, 2 = nächster
+//       Stein), dann nur die geänderten Teile in derselben Reihenfolge und
+//       Kodierung wie im Keyframe, dann die Anzahl der geänderten Zellen und
+//       für jede ein Byte Index (`row * Breite + col`) und ein Byte Farbe.
+// Ändert sich in einem Frame nichts, wird nichts geschickt. Keyframes kommen
+// in festen Abständen und immer dann, wenn sie kürzer sind als die Änderungen
+// (z.B. beim Entfernen von Zeilen). Wer mitten im Spiel dazukommt, wartet auf
+// den nächsten Keyframe.
+
+// Kodiert aufeinanderfolgende Bilder.
+class SpectatorEncoder {
+public:
+  // Höchstens alle `keyframeInterval` Frames ein Keyframe.
+  explicit SpectatorEncoder(int keyframeInterval = FRAMES_PER_SECOND);
+
+  // Hängt die Nachricht für `snapshot` an `out` an (nichts, wenn sich nichts
+  // geändert hat). Gibt zurück, ob es ein Keyframe war.
+  bool encode(const FrameSnapshot &snapshot, std::string &out);
+
+private:
+  void encodeKeyframe(const FrameSnapshot &snapshot, std::string &message);
+
+  int keyframeInterval_;
+  bool started_;
+  int64_t lastFrame_;
+  int64_t lastKeyframe_;
+  // Der Stand beim Zuschauer.
+  FrameSnapshot shown_;
+  std::string message_;
+  std::string cells_;
+};
+
+// Dekodiert den Strom eines `SpectatorEncoder` zurück in ein Bild (ohne
+// Textzeilen). Wirft bei ungültigen Daten eine Exception.
+class SpectatorDecoder {
+public:
+  // Liest alle vollständigen Nachrichten am Anfang von `data` und gibt die
+  // Anzahl der gelesenen Bytes zurück. Änderungen vor dem ersten Keyframe
+  // werden übersprungen.
+  size_t decode(const uint8_t *data, size_t size);
+
+  // Ob schon ein Keyframe kam, erst dann ist `snapshot` gültig.
+  bool synced() const { return synced_; }
+  const FrameSnapshot &snapshot() const { return snapshot_; }
+  int64_t keyframes() const { return keyframes_; }
+  int64_t deltas() const { return deltas_; }
+
+private:
+  void apply(char type, const uint8_t *data, const uint8_t *end);
+
+  bool synced_ = false;
+  int64_t keyframes_ = 0;
+  int64_t deltas_ = 0;
+  FrameSnapshot snapshot_;
+};
+
+struct SpectatorServerOptions {
+  std::string socketPath = "/tmp/tetris-spectate.sock";
+  int keyframeInterval = FRAMES_PER_SECOND;
+  // Hat ein Zuschauer so viel noch nicht abgeholt, bekommt er bis zum
+  // nächsten Keyframe nichts mehr.
+  size_t maxPendingBytes = 64 * 1024;
+};
+
+// Verteilt die Bilder eines Spiels an beliebig viele Zuschauer. Wie beim
+// `RenderThread` übergibt die Hauptschleife Kopien mit `publish`, das nie
+// blockiert. Ein eigener Thread kodiert jedes Bild einmal und schreibt es ohne
+// zu blockieren an alle Zuschauer (epoll). Wer nicht hinterherkommt, wird
+// nicht getrennt, sondern setzt beim nächsten Keyframe wieder ein.
+class SpectatorServer {
+public:
+  // Legt den Socket an (eine alte Datei an `socketPath` wird ersetzt). Wirft
+  // bei Fehlern eine Exception.
+  explicit SpectatorServer(const SpectatorServerOptions &options = {});
+  // Schickt noch das zuletzt übergebene Bild (wartet dafür höchstens 200 ms
+  // auf langsame Zuschauer) und beendet den Thread.
+  ~SpectatorServer();
+  SpectatorServer(const SpectatorServer &) = delete;
+  SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+  void publish(const FrameSnapshot &snapshot);
+
+  int viewers() const { return viewers_; }
+  int64_t bytesSent() const { return bytesSent_; }
+  // Wie oft ein Zuschauer zu langsam war und auf einen Keyframe warten musste.
+  int64_t resyncs() const { return resyncs_; }
+  // Bilder, die `publish` verworfen hat, weil der Thread nicht nachkam.
+  int64_t framesDropped() const { return framesDropped_; }
+
+private:
+  struct Viewer {
+    int fd = -1;
+    std::string out;
+    // Ob der Zuschauer einen Keyframe hat, sonst bekommt er keine Änderungen.
+    bool synced = false;
+    bool waitingForWrite = false;
+  };
+
+  void run();
+  void acceptViewers();
+  void broadcast(const std::string &message, bool keyframe);
+  void writeViewer(Viewer &viewer);
+  void closeViewer(int fd);
+
+  SpectatorServerOptions options_;
+  int listenFd_;
+  int epollFd_;
+  // Weckt den Thread, wenn ein Bild in der Warteschlange ist (eventfd).
+  int wakeFd_;
+  std::atomic<bool> stopRequested_;
+  std::atomic<int> viewers_;
+  std::atomic<int64_t> bytesSent_;
+  std::atomic<int64_t> resyncs_;
+  std::atomic<int64_t> framesDropped_;
+  SpscQueue<FrameSnapshot, 8> queue_;
+  // Ab hier nur vom Thread benutzt.
+  SpectatorEncoder encoder_;
+  FrameSnapshot current_;
+  std::string message_;
+  // Zuschauer nach Dateideskriptor.
+  std::vector<std::unique_ptr<Viewer>> connections_;
+  std::thread thread_;
+};
@@ -0,0 +1,121 @@
+#include "./Spectator.h"
+#include "./TerminalManager.h"
+#include "./Tetris.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+// Schaut einem Spiel zu, das mit `TetrisMain --spectate SOCKET` läuft, bis es
+// vorbei ist oder Escape gedrückt wird. Mit --headless wird nichts gezeichnet,
+// nur am Ende eine Zusammenfassung ausgegeben (z.B. um viele Zuschauer zu
+// simulieren), mit --ansi wie bei TetrisMain ohne ncurses gezeichnet.
+int main(int argc, char **argv) {
+  std::string socketPath;
+  bool headless = false;
+  TerminalBackend backend = TerminalBackend::Ncurses;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      headless = true;
+    } else if (std::strcmp(argv[i], "--ansi") == 0) {
+      backend = TerminalBackend::Ansi;
+    } else if (socketPath.empty() && argv[i][0] != '-') {
+      socketPath = argv[i];
+    } else {
+      socketPath.clear();
+      break;
+    }
+  }
+  if (socketPath.empty()) {
+    std::cerr << "Usage: " << argv[0] << " [--headless] [--ansi] SOCKET"
+              << std::endl;
+    return 1;
+  }
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socketPath.c_str(),
+               sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) < 0) {
+    std::perror(socketPath.c_str());
+    return 1;
+  }
+
+  std::unique_ptr<TerminalManager> terminal;
+  if (!headless) {
+    terminal = std::make_unique<TerminalManager>(gameColors(), backend);
+  }
+  GameView view;
+  SpectatorDecoder decoder;
+  std::vector<uint8_t> buffer;
+  size_t used = 0;
+  int64_t bytesReceived = 0;
+  int64_t framesDrawn = 0;
+  std::string error;
+  bool exitRequested = false;
+  while (!exitRequested) {
+    // Mit Terminal kurz auf Tasten warten, sonst nur auf den Socket.
+    if (terminal) {
+      terminal->waitForInput(std::chrono::milliseconds(5));
+      for (UserInput input = terminal->getUserInput(); !input.isNone();
+           input = terminal->getUserInput()) {
+        exitRequested |= input.isEscape();
+      }
+    }
+    pollfd socketReady{fd, POLLIN, 0};
+    if (poll(&socketReady, 1, terminal ? 0 : -1) <= 0) {
+      continue;
+    }
+    if (buffer.size() - used < 4096) {
+      buffer.resize(used + 65536);
+    }
+    ssize_t n = read(fd, buffer.data() + used, buffer.size() - used);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // Das Spiel ist vorbei (oder die Verbindung weg).
+      break;
+    }
+    bytesReceived += n;
+    used += n;
+    size_t consumed;
+    try {
+      consumed = decoder.decode(buffer.data(), used);
+    } catch (const std::exception &e) {
+      error = e.what();
+      break;
+    }
+    std::memmove(buffer.data(), buffer.data() + consumed, used - consumed);
+    used -= consumed;
+    if (terminal && consumed > 0 && decoder.synced() &&
+        view.draw(*terminal, decoder.snapshot())) {
+      framesDrawn++;
+    }
+  }
+  close(fd);
+  terminal.reset();
+
+  if (!error.empty()) {
+    std::cerr << socketPath << ": " << error << std::endl;
+    return 1;
+  }
+  const FrameSnapshot &last = decoder.snapshot();
+  std::cout << "Frame " << last.frame << ", " << last.piecesPlaced
+            << " pieces, " << last.linesCleared << " lines, score "
+            << last.score << "; " << decoder.keyframes() << " keyframes, "
+            << decoder.deltas() << " deltas, " << bytesReceived << " bytes, "
+            << framesDrawn << " frames drawn" << std::endl;
+  return 0;
+}
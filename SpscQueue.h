@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Warteschlange fester Größe für genau einen schreibenden und einen lesenden
+// Thread, ohne Locks: Jeder Thread schreibt nur seinen eigenen Zähler
+// (`tail_` bzw. `head_`) und liest den des anderen. Die Zähler laufen frei
+// über, die Position im Ring ist der Zähler modulo `N`. `T` wird kopiert,
+// sollte also klein und trivial kopierbar sein.
+template <class T, size_t N> class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N muss eine Zweierpotenz sein");
+
+public:
+  // Nur vom Schreiber: hängt `value` an, false wenn die Schlange voll ist.
+  bool tryPush(const T &value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    slots_[tail % N] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Nur vom Leser: holt das älteste Element, false wenn die Schlange leer ist.
+  bool tryPop(T &value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = slots_[head % N];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Nur vom Leser: verwirft alle Elemente bis auf das neueste, ohne sie zu
+  // kopieren. Gibt die Anzahl der verworfenen zurück.
+  size_t skipToLatest() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    if (tail - head <= 1) {
+      return 0;
+    }
+    head_.store(tail - 1, std::memory_order_release);
+    return tail - 1 - head;
+  }
+
+private:
+  // Die Zähler auf eigenen Cache-Lines, damit die beiden Threads sich nicht
+  // gegenseitig die Line wegnehmen.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::array<T, N> slots_;
+};
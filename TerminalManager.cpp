@@ -3,7 +3,14 @@
 // Author: Hannah Bast <bast@cs.uni-freiburg.de>
 
 #include "./TerminalManager.h"
+#include "./AnsiScreen.h"
+#include <cerrno>
+#include <cstdio>
 #include <ncurses.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
 
 static constexpr size_t systemColors = 16;
 
@@ -20,11 +27,89 @@ bool UserInput::isKeyDown() const { return keycode_ == KEY_DOWN; }
 bool UserInput::isMouseclick() const { return mouseRow_ != -1; }
 bool UserInput::pressA() const { return keycode_ == 'a'; }
 bool UserInput::pressS() const { return keycode_ == 's'; }
+bool UserInput::pressSpace() const { return keycode_ == ' '; }
+bool UserInput::isNone() const { return keycode_ == ERR; }
+
+// ____________________________________________________________________________
+struct TerminalManager::Ansi {
+  Ansi(const std::vector<std::pair<Color, Color>> &colors, int numRows,
+       int numCharCols)
+      : screen(colors, numRows, numCharCols) {}
+  AnsiScreen screen;
+  // Die Einstellungen des Terminals vor dem Start.
+  struct termios savedTermios;
+  // Gelesene, noch nicht ausgewertete Eingabe.
+  std::string input;
+};
+
+namespace {
+// Alternativer Bildschirm, Cursor aus, Mausklicks im SGR-Format, leeren.
+const char ANSI_START[] =
+    "\033[?1049h\033[?25l\033[?1000h\033[?1006h\033[2J";
+const char ANSI_END[] = "\033[0m\033[?1006l\033[?1000l\033[?25h\033[?1049l";
+
+// Schreibt `data` vollständig nach stdout, im Normalfall mit einem `write`.
+void writeAll(const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(STDOUT_FILENO, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+// Liest, was auf stdin ansteht, nachdem bis zu `timeoutMs` darauf gewartet
+// wurde.
+void readInput(std::string &input, int timeoutMs) {
+  struct pollfd fds = {STDIN_FILENO, POLLIN, 0};
+  if (poll(&fds, 1, timeoutMs) <= 0) {
+    return;
+  }
+  char buffer[256];
+  ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+  if (n > 0) {
+    input.append(buffer, n);
+  }
+}
+
+// So lange wartet `readAnsiInput` auf den Rest einer Escape-Sequenz, bevor
+// ein einzelnes Escape als Taste zählt (wie ESCDELAY bei ncurses).
+const int ESCAPE_DELAY_MS = 25;
+} // namespace
 
 // ____________________________________________________________________________
 TerminalManager::TerminalManager(
-    const std::vector<std::pair<Color, Color>> &colors)
+    const std::vector<std::pair<Color, Color>> &colors,
+    TerminalBackend backend)
     : numColors_(colors.size()) {
+  if (backend == TerminalBackend::Ansi) {
+    struct winsize size {};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) < 0 || size.ws_row == 0) {
+      size.ws_row = 24;
+      size.ws_col = 80;
+    }
+    numRows_ = size.ws_row;
+    numCols_ = size.ws_col / 2;
+    ansi_ = std::make_unique<Ansi>(colors, numRows_, size.ws_col);
+    if (tcgetattr(STDIN_FILENO, &ansi_->savedTermios) < 0) {
+      throw std::runtime_error("The ANSI backend requires a terminal on stdin");
+    }
+    // Wie `cbreak` und `noecho`, dazu ohne Warten: `read` kehrt sofort
+    // zurück. Ctrl-C funktioniert weiterhin.
+    struct termios raw = ansi_->savedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    writeAll(ANSI_START, sizeof(ANSI_START) - 1);
+    return;
+  }
   // Initialize ncurses and some settings suitable for gaming.
   initscr();
   cbreak();
@@ -66,16 +151,37 @@ TerminalManager::TerminalManager(
 }
 
 // ____________________________________________________________________________
-TerminalManager::~TerminalManager() { endwin(); }
+TerminalManager::~TerminalManager() {
+  if (ansi_) {
+    writeAll(ANSI_END, sizeof(ANSI_END) - 1);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &ansi_->savedTermios);
+    return;
+  }
+  endwin();
+}
 
 // ____________________________________________________________________________
-void TerminalManager::refresh() { ::refresh(); }
+void TerminalManager::refresh() {
+  if (ansi_) {
+    const std::string &frame = ansi_->screen.compose();
+    writeAll(frame.data(), frame.size());
+    bytesWritten_ += frame.size();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(ncursesMutex_);
+  ::refresh();
+}
 
 // ____________________________________________________________________________
 void TerminalManager::drawPixel(int row, int col, int color) {
+  if (ansi_) {
+    ansi_->screen.drawPixel(row, col, color);
+    return;
+  }
   if (color >= numColors_) {
     throw std::runtime_error("Invalid color given to drawPixel");
   }
+  std::lock_guard<std::mutex> lock(ncursesMutex_);
   attron(COLOR_PAIR(color + systemColors));
   attron(A_REVERSE);
   mvprintw(row, 2 * col, "  ");
@@ -84,7 +190,15 @@ void TerminalManager::drawPixel(int row, int col, int color) {
 
 // ____________________________________________________________________________
 UserInput TerminalManager::getUserInput() {
+  if (ansi_) {
+    return readAnsiInput();
+  }
   UserInput userInput;
+  std::unique_lock<std::mutex> lock(ncursesMutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    userInput.keycode_ = ERR;
+    return userInput;
+  }
   userInput.keycode_ = getch();
   MEVENT event;
   if ((userInput.keycode_ == KEY_MOUSE) && (getmouse(&event) == OK)) {
@@ -96,11 +210,108 @@ UserInput TerminalManager::getUserInput() {
   return userInput;
 }
 
+// ____________________________________________________________________________
+bool TerminalManager::waitForInput(std::chrono::nanoseconds timeout) {
+  if (ansi_ && !ansi_->input.empty()) {
+    return true;
+  }
+  if (timeout.count() < 0) {
+    timeout = std::chrono::nanoseconds(0);
+  }
+  struct pollfd fds = {STDIN_FILENO, POLLIN, 0};
+  struct timespec ts;
+  ts.tv_sec = timeout.count() / 1000000000;
+  ts.tv_nsec = timeout.count() % 1000000000;
+  return ppoll(&fds, 1, &ts, nullptr) > 0;
+}
+
 // ____________________________________________________________________________
 void TerminalManager::drawString(int row, int col, int color, const char *str) {
+  if (ansi_) {
+    ansi_->screen.drawString(row, col, color, str);
+    return;
+  }
   if (color >= numColors_) {
     throw std::runtime_error("Invalid color given to drawString");
   }
+  std::lock_guard<std::mutex> lock(ncursesMutex_);
   attron(COLOR_PAIR(color + systemColors));
   mvprintw(row, 2 * col, "%s", str);
+  attroff(COLOR_PAIR(color + systemColors));
+}
+
+// ____________________________________________________________________________
+UserInput TerminalManager::readAnsiInput() {
+  std::string &input = ansi_->input;
+  UserInput userInput;
+  userInput.keycode_ = ERR;
+  if (input.empty()) {
+    readInput(input, 0);
+  }
+  if (input.empty()) {
+    return userInput;
+  }
+  if (input[0] != 27) {
+    userInput.keycode_ = static_cast<unsigned char>(input[0]);
+    input.erase(0, 1);
+    return userInput;
+  }
+  // Eine Escape-Sequenz kann auf mehrere `read` verteilt ankommen.
+  if (input.size() < 3) {
+    readInput(input, ESCAPE_DELAY_MS);
+  }
+  if (input.size() < 3 || (input[1] != '[' && input[1] != 'O')) {
+    userInput.keycode_ = 27;
+    input.erase(0, 1);
+    return userInput;
+  }
+  // Die Sequenz endet mit dem ersten Zeichen aus @ bis ~.
+  size_t end = 2;
+  while (end < input.size() && (input[end] < '@' || input[end] > '~')) {
+    end++;
+  }
+  if (end == input.size()) {
+    readInput(input, ESCAPE_DELAY_MS);
+    while (end < input.size() && (input[end] < '@' || input[end] > '~')) {
+      end++;
+    }
+    if (end == input.size()) {
+      // Unvollständig, verwerfen.
+      input.clear();
+      return userInput;
+    }
+  }
+  switch (input[end]) {
+  case 'A':
+    userInput.keycode_ = KEY_UP;
+    break;
+  case 'B':
+    userInput.keycode_ = KEY_DOWN;
+    break;
+  case 'C':
+    userInput.keycode_ = KEY_RIGHT;
+    break;
+  case 'D':
+    userInput.keycode_ = KEY_LEFT;
+    break;
+  case 'M':
+  case 'm': {
+    // Maus im SGR-Format: ESC [ < Knopf ; Spalte ; Zeile M (m beim
+    // Loslassen).
+    userInput.keycode_ = KEY_MOUSE;
+    int button, x, y;
+    if (input[end] == 'M' && input[2] == '<' &&
+        std::sscanf(input.c_str() + 3, "%d;%d;%d", &button, &x, &y) == 3 &&
+        button == 0) {
+      userInput.mouseRow_ = y - 1;
+      userInput.mouseCol_ = (x - 1) / 2;
+    }
+    break;
+  }
+  default:
+    // Andere Tasten (Funktionstasten usw.) werden nicht gebraucht.
+    userInput.keycode_ = 0;
+  }
+  input.erase(0, end + 1);
+  return userInput;
 }
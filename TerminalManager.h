@@ -5,7 +5,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -45,13 +51,30 @@ public:
   bool isMouseclick() const;
   bool pressA() const;
   bool pressS() const;
+  bool pressSpace() const;
+  // True if no key was pressed (`getUserInput` had nothing to read).
+  bool isNone() const;
   // The code of the key that was pressed.
   int keycode_;
   int mouseRow_ = -1;
   int mouseCol_ = -1;
 };
 
+// How the `TerminalManager` talks to the terminal.
+enum class TerminalBackend {
+  // Via ncurses, one library call per pixel.
+  Ncurses,
+  // Without ncurses: every frame is composed into one buffer of ANSI escape
+  // sequences (only the changed characters, see `AnsiScreen`) and sent with a
+  // single `write`. Needs a terminal with 256 colors.
+  Ansi,
+};
+
 // A class to draw pixels on or read input from the terminal, using ncurses.
+//
+// Drawing (`drawPixel`, `drawString`, `refresh`) and reading input
+// (`getUserInput`, `waitForInput`) may happen in two different threads, see
+// `RenderThread`. Each side on its own is not thread-safe.
 class TerminalManager {
 public:
   // Constructor: Set up the terminal for use with ncurses commands.
@@ -59,7 +82,8 @@ public:
   // manager: Each pair consists of [foreground color, background color]. The
   // `i-th` color pair in the vector can then later be chosen if `i` is
   // specified as the color argument to `drawPixel` or `drawString`.
-  TerminalManager(const std::vector<std::pair<Color, Color>> &colors);
+  TerminalManager(const std::vector<std::pair<Color, Color>> &colors,
+                  TerminalBackend backend = TerminalBackend::Ncurses);
 
   // Destructor: Clean up the terminal after use.
   ~TerminalManager();
@@ -79,12 +103,32 @@ public:
   int numRows() { return numRows_; }
   int numCols() { return numCols_; }
 
-  // Get user input.
+  // Get user input. Returns no input (`isNone`) while ncurses is busy drawing
+  // in another thread, instead of waiting for it.
   UserInput getUserInput();
 
+  // Wait until user input is available or the timeout has passed, without
+  // using any CPU in the meantime. Returns true if there is input to read.
+  bool waitForInput(std::chrono::nanoseconds timeout);
+
+  // Bytes sent to the terminal so far (only known for the ANSI backend).
+  int64_t bytesWritten() const { return bytesWritten_.load(); }
+
 private:
+  // State of the ANSI backend, defined in TerminalManager.cpp.
+  struct Ansi;
+
+  // Read the next key from the input of the ANSI backend.
+  UserInput readAnsiInput();
+
   // The logical dimensions of the screen.
   int numRows_;
   int numCols_;
   int numColors_;
+  std::unique_ptr<Ansi> ansi_;
+  std::atomic<int64_t> bytesWritten_{0};
+  // ncurses itself is not thread-safe (`getch` may even draw), all ncurses
+  // calls hold this lock. The ANSI backend does not need it, input and output
+  // do not share any state there.
+  std::mutex ncursesMutex_;
 };
@@ -1,7 +1,9 @@
 #include "Tetris.h"
 #include "./TerminalManager.h"
 #include "./Tetromino.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -11,40 +13,54 @@
 
 using namespace std;
 
-const int FIELD_WIDTH = 10;
-const int FIELD_HEIGHT = 20;
 const int BORDER_COLOR = 1;
-// const int TICK_RATE_MS = 500;
-const int LEVEL_SPEEDS[] = {48, 43, 38, 33, 28, 23, 18, 13, 8, 6,
-                            5,  5,  5,  4,  4,  4,  3,  3,  3, 2,
-                            2,  2,  2,  2,  2,  2,  2,  2,  2, 1};
-const int FRAMES_PER_SECOND = 60;
-
-vector<vector<int>> initializeField(int width, int height) {
-  vector<vector<int>> field(height, vector<int>(width, 0));
-  return field;
+const int GHOST_COLOR = 9;
+
+FieldRenderer::FieldRenderer() {
+  // Der Rahmen steht fest, er wird nur einmal ins back-Bild geschrieben.
+  for (int row = 0; row < kRows; row++) {
+    for (int col = 0; col < kCols; col++) {
+      back_[row][col] = BORDER_COLOR;
+    }
+  }
+  invalidate();
+}
+
+void FieldRenderer::invalidate() {
+  for (auto &row : front_) {
+    row.fill(-1);
+  }
 }
 
-void drawFieldWithFixedBorders(TerminalManager &terminal,
-                               const vector<vector<int>> &field) {
-  for (int row = 0; row < FIELD_HEIGHT + 2; row++) {
-    for (int col = 0; col < FIELD_WIDTH + 2; col++) {
-      if (row == 0 || row == FIELD_HEIGHT + 1 || col == 0 ||
-          col == FIELD_WIDTH + 1) {
-        terminal.drawPixel(row, col, BORDER_COLOR);
-      } else {
-        int color = field[row - 1][col - 1];
-        terminal.drawPixel(row, col, color);
+void FieldRenderer::compose(const Board &field, const Tetromino &tetromino) {
+  for (int row = 0; row < Board::kHeight; row++) {
+    for (int col = 0; col < Board::kWidth; col++) {
+      back_[row + 1][col + 1] = field.getColor(row, col);
+    }
+  }
+  // Erst der Schatten an der Stelle, an der der Stein landen würde, dann der
+  // Stein selbst (er kann den Schatten überdecken).
+  const PieceRotation &shape = tetromino.getShape();
+  auto [pieceRow, pieceCol] = tetromino.getPosition();
+  int ghostRow = tetromino.landingRow(field);
+  for (int r = 0; r < shape.height; r++) {
+    for (int c = 0; c < shape.width; c++) {
+      if ((shape.rows[r] >> c) & 1) {
+        back_[ghostRow + r + 1][pieceCol + c + 1] = GHOST_COLOR;
+      }
+    }
+  }
+  for (int r = 0; r < shape.height; r++) {
+    for (int c = 0; c < shape.width; c++) {
+      if ((shape.rows[r] >> c) & 1) {
+        back_[pieceRow + r + 1][pieceCol + c + 1] = tetromino.getColor();
       }
     }
   }
-  terminal.refresh();
 }
 
-int main() {
-  vector<vector<int>> field = initializeField(FIELD_WIDTH, FIELD_HEIGHT);
-
-  std::vector<std::pair<Color, Color>> colors = {
+std::vector<std::pair<Color, Color>> gameColors() {
+  return {
       {Color(1.0, 1.0, 1.0), Color(1.0, 1.0, 1.0)}, // Black
       {Color(1.0, 1.0, 1.0), Color(1.0, 1.0, 1.0)}, // Red on Blue
       {Color(1.0, 1.0, 1.0), Color(1.0, 1.0, 1.0)}, // Green on Yellow
@@ -54,73 +70,166 @@ int main() {
       {Color(0.0, 1.0, 1.0), Color(1.0, 0.0, 1.0)}, // Cyan on Magenta
       {Color(1.0, 1.0, 1.0), Color(0.0, 0.0, 0.0)}, // White on Black
       {Color(0.0, 0.0, 0.0), Color(1.0, 1.0, 1.0)}, // Black on White
+      {Color(0.4, 0.4, 0.4), Color(0.0, 0.0, 0.0)}, // Gray (ghost piece)
   };
+}
+
+void FrameSnapshot::capture(const GameState &state) {
+  field = state.field;
+  current = state.currentTetromino;
+  next = state.nextTetromino;
+  frame = state.frame;
+  level = state.level;
+  linesCleared = state.totalLinesCleared;
+  score = state.score;
+  piecesPlaced = state.piecesPlaced;
+}
+
+void FrameSnapshot::setText(int line, const std::string &value) {
+  std::snprintf(text[line], kTextColumns, "%s", value.c_str());
+}
 
-  TerminalManager terminal(colors);
-
-  int totalLinesCleared = 0;
-  int linesClearedAtOnce = 0;
-  int level = 0;
-
-  Tetrominos tetrominos;
-  Tetromino currentTetromino = tetrominos.getRandomTetromino();
-  Tetromino nextTetromino = tetrominos.getRandomTetromino();
-  currentTetromino.setPosition(
-      0, FIELD_WIDTH / 2 - currentTetromino.getShape()[0].size() / 2);
-
-  bool running = false;
-  auto lastTick = std::chrono::steady_clock::now();
-  int TICK_RATE_MS = calculateTickRate(level);
-  // Zeichne das nächste Tetromino einmal außerhalb der Schleife
-  nextTetromino.drawNextTetromino(terminal, 2, FIELD_WIDTH + 5, 4, 4);
-
-  while (!running) {
-    terminal.drawString(0, FIELD_WIDTH + 5, 0,
-                        ("Level: " + std::to_string(level)).c_str());
-    updateTetromino(currentTetromino, tetrominos, field, lastTick, running,
-                    FIELD_WIDTH, TICK_RATE_MS, totalLinesCleared,
-                    linesClearedAtOnce, nextTetromino, terminal, level);
-
-    vector<vector<int>> tempField = field;
-    placeTetrominoInField(tempField, currentTetromino);
-    drawFieldWithFixedBorders(terminal, tempField);
-
-    UserInput userinput = terminal.getUserInput();
-    int dx = 0;
-    int dy = 0;
-    if (userinput.isEscape()) {
-      running = true;
-    } else if (userinput.isKeyLeft()) {
-      dx = -1;
-    } else if (userinput.isKeyRight()) {
-      dx = 1;
-    } else if (userinput.isKeyDown()) {
-      dy = 1;
-    } else if (userinput.pressS()) {
-      currentTetromino.rotateClockwise(field);
-    } else if (userinput.pressA()) {
-      currentTetromino.rotateCounterClockwise(field);
+bool GameView::draw(TerminalManager &terminal, const FrameSnapshot &snapshot) {
+  // Level, Zeilen, Punkte und nächstes Tetromino nur zeichnen, wenn sie sich
+  // geändert haben.
+  const int textCol = Board::kWidth + 5;
+  bool textChanged = false;
+  if (snapshot.piecesPlaced != drawnNextFor_) {
+    snapshot.next.drawNextTetromino(terminal, 2, textCol, 4, 4);
+    drawnNextFor_ = snapshot.piecesPlaced;
+    textChanged = true;
+  }
+  if (snapshot.level != drawnLevel_) {
+    terminal.drawString(0, textCol, 0,
+                        ("Level: " + std::to_string(snapshot.level)).c_str());
+    drawnLevel_ = snapshot.level;
+    textChanged = true;
+  }
+  if (snapshot.linesCleared != drawnLines_) {
+    terminal.drawString(
+        1, textCol, 0,
+        ("Lines: " + std::to_string(snapshot.linesCleared)).c_str());
+    drawnLines_ = snapshot.linesCleared;
+    textChanged = true;
+  }
+  if (snapshot.score != drawnScore_) {
+    // Unter der Vorschau (Zeilen 2 bis 5).
+    terminal.drawString(6, textCol, 0,
+                        ("Score: " + std::to_string(snapshot.score)).c_str());
+    drawnScore_ = snapshot.score;
+    textChanged = true;
+  }
+  if (snapshot.textVersion != drawnText_) {
+    for (int line = 0; line < snapshot.numTextLines; line++) {
+      terminal.drawString(8 + line, textCol, 0, snapshot.text[line]);
     }
+    drawnText_ = snapshot.textVersion;
+    textChanged = true;
+  }
+  int changed = renderer_.drawFieldWithFixedBorders(terminal, snapshot.field,
+                                                    snapshot.current);
+  if (changed == 0 && textChanged) {
+    terminal.refresh();
+  }
+  return changed > 0 || textChanged;
+}
 
-    if (!currentTetromino.move(dx, dy, field)) {
-      if (dy > 0) {
-        placeTetrominoInField(field, currentTetromino);
-        checkAndRemoveFullLines(field, totalLinesCleared, linesClearedAtOnce);
-        currentTetromino = nextTetromino; // Verwende das nächste Tetromino
-        currentTetromino.setPosition(
-            0, FIELD_WIDTH / 2 - currentTetromino.getShape()[0].size() / 2);
-        nextTetromino =
-            tetrominos
-                .getRandomTetromino(); // Generiere ein neues nächstes Tetromino
-        if (!currentTetromino.move(0, 0, field)) {
-          running = true;
-        }
-        // Zeichne das nächste Tetromino nach dem Setzen des aktuellen
-        // Tetrominos
-        nextTetromino.drawNextTetromino(terminal, 2, FIELD_WIDTH + 5, 4, 4);
-      }
+FrameClock::FrameClock()
+    : frameDuration_(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / FRAMES_PER_SECOND))),
+      nextFrame_(Clock::now() + frameDuration_) {}
+
+FrameClock::Clock::duration FrameClock::timeUntilNextFrame() const {
+  auto remaining = nextFrame_ - Clock::now();
+  return remaining.count() > 0 ? remaining : Clock::duration::zero();
+}
+
+int FrameClock::takeDueFrames() {
+  auto now = Clock::now();
+  if (now < nextFrame_) {
+    return 0;
+  }
+  int frames = 1 + (now - nextFrame_) / frameDuration_;
+  if (frames > FRAMES_PER_SECOND) {
+    frames = 1;
+    nextFrame_ = now + frameDuration_;
+  } else {
+    nextFrame_ += frames * frameDuration_;
+  }
+  return frames;
+}
+
+Action actionFromInput(const UserInput &userinput) {
+  if (userinput.isKeyLeft()) {
+    return Action::Left;
+  } else if (userinput.isKeyRight()) {
+    return Action::Right;
+  } else if (userinput.isKeyDown()) {
+    return Action::SoftDrop;
+  } else if (userinput.isKeyUp() || userinput.pressSpace()) {
+    return Action::HardDrop;
+  } else if (userinput.pressS()) {
+    return Action::RotateClockwise;
+  } else if (userinput.pressA()) {
+    return Action::RotateCounterClockwise;
+  }
+  return Action::None;
+}
+
+InputRepeater::InputRepeater(RepeatSettings settings)
+    : settings_(settings), held_(Action::None), repeating_(false),
+      pressedFrame_(0), lastEventFrame_(0), nextRepeatFrame_(0) {}
+
+void InputRepeater::keyEvent(Action action, int64_t frame,
+                             std::vector<Action> &actions) {
+  if (action == Action::None) {
+    return;
+  }
+  if (action == held_ && frame - lastEventFrame_ <= settings_.releaseFrames) {
+    // So schnell kommen nur die Wiederholungen des Terminals: die Taste wird
+    // gehalten, ab jetzt wiederholt `tick`.
+    if (!repeating_) {
+      repeating_ = true;
+      nextRepeatFrame_ = std::max(frame, pressedFrame_ + settings_.das);
     }
+    lastEventFrame_ = frame;
+    return;
+  }
+  // Ein neuer Druck. Die erste Wiederholung des Terminals kommt erst nach
+  // dessen Verzögerung (meist 250-600 ms) und sieht genauso aus, deshalb
+  // zählt DAS bei derselben Taste weiter ab dem ursprünglichen Druck.
+  if (action != held_ || frame - lastEventFrame_ > FRAMES_PER_SECOND) {
+    pressedFrame_ = frame;
   }
+  held_ = action;
+  repeating_ = false;
+  lastEventFrame_ = frame;
+  actions.push_back(action);
+}
 
-  return 0;
+void InputRepeater::tick(int64_t frame, std::vector<Action> &actions) {
+  if (!repeating_) {
+    return;
+  }
+  if (frame - lastEventFrame_ > settings_.releaseFrames) {
+    held_ = Action::None;
+    repeating_ = false;
+    return;
+  }
+  if (held_ != Action::Left && held_ != Action::Right &&
+      held_ != Action::SoftDrop) {
+    return;
+  }
+  if (frame < nextRepeatFrame_) {
+    return;
+  }
+  if (settings_.arr == 0 && held_ != Action::SoftDrop) {
+    // Mehr Schritte braucht es nie bis zur Wand. Nach unten nicht, sonst
+    // würde der Stein abgelegt und der nächste gleich mit hinunterfallen.
+    actions.insert(actions.end(), Board::kWidth, held_);
+    nextRepeatFrame_ = frame + 1;
+  } else {
+    actions.push_back(held_);
+    nextRepeatFrame_ = frame + std::max(settings_.arr, 1);
+  }
 }
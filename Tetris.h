@@ -1,16 +1,186 @@
 #pragma once
 
+#include "Board.h"
+#include "Game.h"
 #include "TerminalManager.h"
 #include "Tetromino.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 
-std::vector<std::vector<int>> initializeField(int width, int height);
+// Zeichnet das Spielfeld mit Rahmen und dem fallenden Stein. Das zuletzt
+// gezeichnete Bild wird gemerkt (front) und mit dem neuen Bild (back)
+// verglichen, an das Terminal gehen nur die Zellen, die sich geändert haben.
+class FieldRenderer {
+public:
+  static constexpr int kRows = Board::kHeight + 2;
+  static constexpr int kCols = Board::kWidth + 2;
 
-void drawFieldWithFixedBorders(TerminalManager &terminal,
-                               const std::vector<std::vector<int>> &field);
+  FieldRenderer();
+
+  // Zeichnet Feld und Stein (als Overlay, ohne das Feld zu kopieren) und ruft
+  // `refresh` auf, falls sich etwas geändert hat. Gibt die Anzahl der
+  // neu gezeichneten Zellen zurück. `Terminal` ist normalerweise
+  // `TerminalManager`, es reicht aber alles mit `drawPixel` und `refresh`
+  // (z.B. ein Null-Terminal in den Benchmarks).
+  template <class Terminal>
+  int drawFieldWithFixedBorders(Terminal &terminal, const Board &field,
+                                const Tetromino &tetromino) {
+    compose(field, tetromino);
+    return flush(terminal);
+  }
+
+  // Die beiden Hälften von `drawFieldWithFixedBorders`, einzeln aufrufbar
+  // damit die Zeitmessung sie getrennt erfassen kann: `compose` schreibt das
+  // neue Bild ins back-Bild, `flush` schickt die Unterschiede ans Terminal.
+  void compose(const Board &field, const Tetromino &tetromino);
+
+  template <class Terminal> int flush(Terminal &terminal) {
+    int changed = 0;
+    for (int row = 0; row < kRows; row++) {
+      for (int col = 0; col < kCols; col++) {
+        if (back_[row][col] != front_[row][col]) {
+          terminal.drawPixel(row, col, back_[row][col]);
+          front_[row][col] = back_[row][col];
+          changed++;
+        }
+      }
+    }
+    if (changed > 0) {
+      terminal.refresh();
+    }
+    return changed;
+  }
+
+  // Erzwingt, dass beim nächsten Aufruf wieder alle Zellen gezeichnet werden.
+  void invalidate();
+
+private:
+  using Frame = std::array<std::array<int8_t, kCols>, kRows>;
+  Frame front_;
+  Frame back_;
+};
+
+// Alles, was für ein Bild gebraucht wird, als Kopie: Die Spiellogik kann
+// weiterlaufen, während (z.B. in einem anderen Thread) gezeichnet wird. Ohne
+// Zeiger und Strings, also trivial kopierbar.
+struct FrameSnapshot {
+  static constexpr int kTextLines = 8;
+  static constexpr int kTextColumns = 48;
+
+  Board field;
+  Tetromino current{0};
+  Tetromino next{0};
+  int64_t frame = 0;
+  int level = 0;
+  int linesCleared = 0;
+  int64_t score = 0;
+  int piecesPlaced = 0;
+  // Zusätzliche Textzeilen unter der Vorschau (z.B. die Statistik). Werden
+  // nur neu gezeichnet, wenn sich `textVersion` ändert.
+  int numTextLines = 0;
+  int64_t textVersion = 0;
+  char text[kTextLines][kTextColumns] = {};
+
+  // Übernimmt den Zustand des Spiels, der Text bleibt.
+  void capture(const GameState &state);
+
+  // Setzt die Textzeile `line` (zu lange Zeilen werden abgeschnitten).
+  void setText(int line, const std::string &value);
+};
+
+// Zeichnet ein `FrameSnapshot`: Feld, Vorschau, Level, Zeilen, Punkte und
+// Text. Wie
+// bei `FieldRenderer` geht nur ans Terminal, was sich seit dem letzten Bild
+// geändert hat.
+class GameView {
+public:
+  // Gibt true zurück, wenn etwas gezeichnet wurde (dann auch mit `refresh`).
+  bool draw(TerminalManager &terminal, const FrameSnapshot &snapshot);
+
+private:
+  FieldRenderer renderer_;
+  int drawnNextFor_ = -1;
+  int drawnLevel_ = -1;
+  int drawnLines_ = -1;
+  int64_t drawnScore_ = -1;
+  int64_t drawnText_ = 0;
+};
+
+// Taktgeber für die Hauptschleife: liefert feste Frames von 1/60 s, damit die
+// Schwerkraft nicht davon abhängt, wie schnell der Rechner die Schleife
+// durchläuft.
+class FrameClock {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  FrameClock();
+
+  // Zeit bis der nächste Frame fällig ist (0, wenn er schon fällig ist).
+  Clock::duration timeUntilNextFrame() const;
+
+  // Anzahl der seit dem letzten Aufruf fälligen Frames. Liegt die Schleife
+  // mehr als eine Sekunde zurück (z.B. nach Ctrl+Z), wird neu synchronisiert
+  // statt alle verpassten Frames nachzuholen.
+  int takeDueFrames();
+
+private:
+  Clock::duration frameDuration_;
+  Clock::time_point nextFrame_;
+};
+
+// Übersetzt eine Taste in die passende Aktion für die Spiellogik.
+Action actionFromInput(const UserInput &userinput);
+
+// Einstellungen für gehaltene Tasten, alle Werte in Frames.
+struct RepeatSettings {
+  // Delayed Auto Shift: so lange muss eine Taste gehalten werden, bis der
+  // Stein von selbst weiterläuft.
+  int das = 10;
+  // Auto Repeat Rate: danach ein Schritt alle `arr` Frames, bei 0 läuft der
+  // Stein im selben Frame bis zur Wand (nach unten dann einer pro Frame).
+  int arr = 2;
+  // Das Terminal meldet kein Loslassen, nur die Wiederholungen des
+  // Betriebssystems. Kommt so lange keine Wiederholung mehr, gilt die Taste
+  // als losgelassen.
+  int releaseFrames = 6;
+};
+
+// Macht aus den Tastendrücken des Terminals die Aktionen für die Spiellogik.
+// Ein Druck ergibt sofort eine Aktion, die schnellen Wiederholungen des
+// Terminals (mit dessen Rate) werden verschluckt. Stattdessen erzeugt `tick`
+// für Links, Rechts und Runter die Wiederholungen nach `RepeatSettings`. Da
+// das Terminal ein Halten erst mit seinen Wiederholungen verrät, beginnt DAS
+// frühestens dann.
+class InputRepeater {
+public:
+  explicit InputRepeater(RepeatSettings settings = RepeatSettings());
+
+  // Eine Taste mit der Aktion `action` kam im Frame `frame` an. Hängt die
+  // auszuführenden Aktionen an `actions` an.
+  void keyEvent(Action action, int64_t frame, std::vector<Action> &actions);
+
+  // Der Frame `frame` beginnt. Hängt die Wiederholungen der gehaltenen Taste
+  // an `actions` an.
+  void tick(int64_t frame, std::vector<Action> &actions);
+
+private:
+  RepeatSettings settings_;
+  Action held_;
+  bool repeating_;
+  int64_t pressedFrame_;
+  int64_t lastEventFrame_;
+  int64_t nextRepeatFrame_;
+};
 // void placeTetrominoInField(vector<vector<int>> &field, const Tetromino&
 // tetromino);
 
+// Die Farbpaare für `TerminalManager`, der Index ist die Farbe einer Zelle.
+std::vector<std::pair<Color, Color>> gameColors();
+
 const Color COLOR_BLACK(0.0, 0.0, 0.0);
 const Color COLOR_RED(1.0, 0.0, 0.0);
 const Color COLOR_GREEN(0.0, 1.0, 0.0);
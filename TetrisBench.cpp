@@ -0,0 +1,524 @@
+#include "./BatchEvaluator.h"
+#include "./Board.h"
+#include "./Bot.h"
+#include "./Corpus.h"
+#include "./Game.h"
+#include "./PerfectClear.h"
+#include "./Placement.h"
+#include "./Tetris.h"
+#include "./Tetromino.h"
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Benchmarks for the hot paths of the game. Besides the time per operation,
+// every benchmark reports the heap allocations per operation ("allocs/op").
+
+// Count all heap allocations of the process.
+static std::atomic<int64_t> numAllocations(0);
+
+void *operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// Report allocations per iteration since `before`.
+static void reportAllocations(benchmark::State &state, int64_t before) {
+  state.counters["allocs/op"] = benchmark::Counter(
+      static_cast<double>(numAllocations.load() - before),
+      benchmark::Counter::kAvgIterations);
+}
+
+// A position from a real game: the field and the piece about to fall.
+struct Position {
+  Board field;
+  Tetromino tetromino;
+};
+
+// Positions from seeded bot games (see Corpus.h), so the benchmarks see
+// realistic stacks instead of an empty field: the corpus file named by
+// $TETRIS_CORPUS (written by CorpusMain), mapped as it is, otherwise 65536
+// positions generated at startup. Compare timings only between runs on the
+// same corpus.
+static const Corpus &corpus() {
+  static const std::unique_ptr<Corpus> instance = [] {
+    if (const char *path = std::getenv("TETRIS_CORPUS")) {
+      auto mapped = std::make_unique<Corpus>(path);
+      if (mapped->size() == 0) {
+        throw std::runtime_error(std::string("Empty corpus file ") + path);
+      }
+      benchmark::AddCustomContext("corpus", path);
+      return mapped;
+    }
+    CorpusOptions options;
+    options.numPositions = 1 << 16;
+    auto generated = std::make_unique<Corpus>(options, generateCorpus(options));
+    benchmark::AddCustomContext("corpus", "generated");
+    return generated;
+  }();
+  return *instance;
+}
+
+// Turns the corpus records into positions for a benchmark, a chunk at a
+// time and outside of the timed region, so a corpus of millions of
+// positions is walked through without converting (or holding) all of them.
+// `Fill` appends the positions for one record.
+class PositionStream {
+public:
+  using Fill = std::function<void(const CorpusRecord &,
+                                  std::vector<Position> &)>;
+
+  static void current(const CorpusRecord &record,
+                      std::vector<Position> &positions) {
+    Board field;
+    record.loadField(field);
+    positions.push_back({field, record.tetromino()});
+  }
+
+  // All final placements of the current piece.
+  static void landed(const CorpusRecord &record,
+                     std::vector<Position> &positions) {
+    static PlacementGenerator generator;
+    Board field;
+    record.loadField(field);
+    for (const Tetromino &placement :
+         generator.generate(field, Tetromino(record.piece))) {
+      positions.push_back({field, placement});
+    }
+  }
+
+  explicit PositionStream(benchmark::State &state, Fill fill = current)
+      : state_(state), fill_(std::move(fill)), record_(0), index_(0) {
+    positions_.reserve(kChunk + 4 * Board::kWidth);
+  }
+
+  Position &next() {
+    if (index_ == positions_.size()) {
+      state_.PauseTiming();
+      positions_.clear();
+      while (positions_.size() < kChunk) {
+        fill_(corpus()[record_], positions_);
+        record_ = record_ + 1 < corpus().size() ? record_ + 1 : 0;
+      }
+      index_ = 0;
+      state_.ResumeTiming();
+    }
+    return positions_[index_++];
+  }
+
+private:
+  static constexpr size_t kChunk = 4096;
+
+  benchmark::State &state_;
+  Fill fill_;
+  std::vector<Position> positions_;
+  size_t record_;
+  size_t index_;
+};
+
+// ____________________________________________________________________________
+static void BM_IsValidPosition(benchmark::State &state) {
+  PositionStream positions(state);
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Tetromino tetromino = position.tetromino;
+    benchmark::DoNotOptimize(tetromino.move(0, 0, position.field));
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_IsValidPosition);
+
+// ____________________________________________________________________________
+static void BM_Move(benchmark::State &state) {
+  PositionStream positions(state);
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Tetromino tetromino = position.tetromino;
+    benchmark::DoNotOptimize(tetromino.move(-1, 0, position.field));
+    benchmark::DoNotOptimize(tetromino.move(1, 0, position.field));
+    benchmark::DoNotOptimize(tetromino.move(0, 1, position.field));
+    benchmark::DoNotOptimize(tetromino);
+  }
+  state.SetItemsProcessed(3 * state.iterations());
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_Move);
+
+// ____________________________________________________________________________
+static void BM_Rotate(benchmark::State &state) {
+  PositionStream positions(state);
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Tetromino tetromino = position.tetromino;
+    tetromino.rotateClockwise(position.field);
+    tetromino.rotateCounterClockwise(position.field);
+    benchmark::DoNotOptimize(tetromino);
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_Rotate);
+
+// ____________________________________________________________________________
+// Arg 1: landing row from the column heights, Arg 0: row by row with `move`.
+static void BM_HardDrop(benchmark::State &state) {
+  PositionStream positions(state);
+  const bool fromHeights = state.range(0);
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Tetromino tetromino = position.tetromino;
+    if (fromHeights) {
+      tetromino.hardDrop(position.field);
+    } else {
+      while (tetromino.move(0, 1, position.field)) {
+      }
+    }
+    benchmark::DoNotOptimize(tetromino);
+  }
+  state.SetItemsProcessed(state.iterations());
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_HardDrop)->Arg(1)->Arg(0);
+
+// ____________________________________________________________________________
+static void BM_PlaceTetrominoInField(benchmark::State &state) {
+  PositionStream positions(state, PositionStream::landed);
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Board field = position.field;
+    placeTetrominoInField(field, position.tetromino);
+    benchmark::DoNotOptimize(field);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlaceTetrominoInField);
+
+// ____________________________________________________________________________
+static void BM_ClearFullLines(benchmark::State &state) {
+  // Corpus fields with `lines` full rows at the bottom. The copy of the field
+  // is part of the measurement, see BM_CopyBoard for its cost alone.
+  const int lines = state.range(0);
+  PositionStream positions(state, [lines](const CorpusRecord &record,
+                                          std::vector<Position> &result) {
+    PositionStream::current(record, result);
+    Board &field = result.back().field;
+    for (int row = Board::kHeight - lines; row < Board::kHeight; row++) {
+      for (int col = 0; col < Board::kWidth; col++) {
+        field.setCell(row, col, 1 + col % 7);
+      }
+    }
+  });
+  Board::RowMask cleared;
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    Board field = positions.next().field;
+    field.clearFullLines(&cleared);
+    benchmark::DoNotOptimize(field);
+    benchmark::DoNotOptimize(cleared);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_ClearFullLines)->DenseRange(0, 4);
+
+// ____________________________________________________________________________
+// Board operations on every board size: vertical I pieces fall into one
+// column after the other (landing, placing, clearing), every full round
+// clears four lines.
+template <class B> static void BM_BoardDropAndClear(benchmark::State &state) {
+  const PieceMask iShape[] = {1, 1, 1, 1};
+  const uint8_t iBottoms[] = {3};
+  B board;
+  int col = 0;
+  int64_t lines = 0;
+  for (auto _ : state) {
+    int row = board.landingRow(iShape, iBottoms, 4, 1, 0, col);
+    board.place(iShape, 4, row, col, 1);
+    lines += board.clearFullLines();
+    col = (col + 1) % B::kWidth;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["lines/op"] =
+      benchmark::Counter(lines, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(BM_BoardDropAndClear, Board);
+BENCHMARK_TEMPLATE(BM_BoardDropAndClear, TallBoard);
+BENCHMARK_TEMPLATE(BM_BoardDropAndClear, WideBoard);
+BENCHMARK_TEMPLATE(BM_BoardDropAndClear, HugeBoard);
+
+// ____________________________________________________________________________
+static void BM_CopyBoard(benchmark::State &state) {
+  PositionStream positions(state);
+  for (auto _ : state) {
+    Board field = positions.next().field;
+    benchmark::DoNotOptimize(field);
+  }
+}
+BENCHMARK(BM_CopyBoard);
+
+// ____________________________________________________________________________
+static void BM_GetRandomTetromino(benchmark::State &state) {
+  Tetrominos tetrominos(1, static_cast<RandomizerMode>(state.range(0)));
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tetrominos.getRandomTetromino());
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_GetRandomTetromino)
+    ->Arg(static_cast<int>(RandomizerMode::Classic))
+    ->Arg(static_cast<int>(RandomizerMode::Bag));
+
+// A terminal that only counts what would be drawn.
+struct NullTerminal {
+  void drawPixel(int row, int col, int color) {
+    benchmark::DoNotOptimize(row + col + color);
+    pixels++;
+  }
+  void refresh() { refreshes++; }
+  int64_t pixels = 0;
+  int64_t refreshes = 0;
+};
+
+// ____________________________________________________________________________
+static void BM_DrawFieldWithFixedBorders(benchmark::State &state) {
+  // range(0) == 1: repaint everything every frame (as after `invalidate`),
+  // range(0) == 0: a typical frame where only the falling piece moved.
+  const bool fullRepaint = state.range(0);
+  PositionStream positions(state);
+  FieldRenderer renderer;
+  NullTerminal terminal;
+  const Position *position = nullptr;
+  size_t i = 0;
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    if (i % 20 == 0) {
+      position = &positions.next();
+    }
+    Tetromino tetromino = position->tetromino;
+    tetromino.move(0, i % 20, position->field);
+    i++;
+    if (fullRepaint) {
+      renderer.invalidate();
+    }
+    renderer.drawFieldWithFixedBorders(terminal, position->field, tetromino);
+  }
+  state.counters["pixels/op"] = benchmark::Counter(
+      terminal.pixels, benchmark::Counter::kAvgIterations);
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_DrawFieldWithFixedBorders)->Arg(1)->Arg(0);
+
+// ____________________________________________________________________________
+static void BM_GeneratePlacements(benchmark::State &state) {
+  // From the spawn point, the way the bot calls it.
+  PositionStream positions(state, [](const CorpusRecord &record,
+                                     std::vector<Position> &result) {
+    PositionStream::current(record, result);
+    result.back().tetromino = Tetromino(record.piece);
+  });
+  PlacementGenerator generator;
+  int64_t placements = 0;
+  Board first;
+  corpus()[0].loadField(first);
+  generator.generate(first, Tetromino(corpus()[0].piece));
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    placements += generator.generate(position.field, position.tetromino).size();
+  }
+  state.SetItemsProcessed(placements);
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_GeneratePlacements);
+
+// ____________________________________________________________________________
+// Features of all landed placements, one board at a time with
+// `computeFeatures` (the way the bot scores them).
+static void BM_ComputeFeatures(benchmark::State &state) {
+  PositionStream positions(state, PositionStream::landed);
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    Board placed = position.field;
+    const PieceRotation &shape = position.tetromino.getShape();
+    auto [row, col] = position.tetromino.getPosition();
+    placed.place(shape.rows, shape.height, row, col, 1);
+    benchmark::DoNotOptimize(computeFeatures(placed.getRows().data()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ComputeFeatures);
+
+// ____________________________________________________________________________
+// The same placements scored with the features the board keeps up to date:
+// only the rows and columns of the piece are looked at.
+static void BM_FeaturesAfter(benchmark::State &state) {
+  PositionStream positions(state, PositionStream::landed);
+  for (auto _ : state) {
+    const Position &position = positions.next();
+    const PieceRotation &shape = position.tetromino.getShape();
+    auto [row, col] = position.tetromino.getPosition();
+    benchmark::DoNotOptimize(position.field.featuresAfter(
+        shape.rows, shape.height, shape.width, row, col));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FeaturesAfter);
+
+// ____________________________________________________________________________
+// `featuresAfter` for a T in every column on top of an 8-row stack with two
+// holes per row, on every board size: the cost should not grow with the
+// height of the board, only (slightly) with its width.
+template <class B> static void BM_FeaturesAfterBySize(benchmark::State &state) {
+  const PieceRotation &shape = PIECES[PIECE_T].rotations[0];
+  B board;
+  Random random(1);
+  for (int row = B::kHeight - 8; row < B::kHeight; row++) {
+    for (int col = 0; col < B::kWidth; col++) {
+      board.setCell(row, col, 1);
+    }
+    board.setCell(row, random.below(B::kWidth), 0);
+    board.setCell(row, random.below(B::kWidth), 0);
+  }
+  int col = 0;
+  for (auto _ : state) {
+    int row = board.landingRow(shape.rows, shape.bottoms, shape.height,
+                               shape.width, 0, col);
+    benchmark::DoNotOptimize(
+        board.featuresAfter(shape.rows, shape.height, shape.width, row, col));
+    col = col + 1 < B::kWidth - shape.width + 1 ? col + 1 : 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_FeaturesAfterBySize, Board);
+BENCHMARK_TEMPLATE(BM_FeaturesAfterBySize, TallBoard);
+BENCHMARK_TEMPLATE(BM_FeaturesAfterBySize, WideBoard);
+BENCHMARK_TEMPLATE(BM_FeaturesAfterBySize, HugeBoard);
+
+// ____________________________________________________________________________
+// One step of the bot's lookahead: place, clear and take it back with
+// `undo`, instead of copying the board (BM_CopyBoard).
+static void BM_PlaceAndUndo(benchmark::State &state) {
+  PositionStream positions(state, PositionStream::landed);
+  Board::Undo undo;
+  for (auto _ : state) {
+    Position &position = positions.next();
+    placeTetrominoInField(position.field, position.tetromino, &undo);
+    position.field.clearFullLines(nullptr, &undo);
+    benchmark::DoNotOptimize(position.field.features());
+    position.field.undo(undo);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PlaceAndUndo);
+
+// ____________________________________________________________________________
+// The same boards in batches of 256 with `evaluateBatch`, the argument is the
+// `SimdLevel` (0 = scalar, 1 = SSE2, 2 = AVX2).
+static void BM_EvaluateBatch(benchmark::State &state) {
+  SimdLevel level = static_cast<SimdLevel>(state.range(0));
+  if (level > detectSimdLevel()) {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+  // The batches are built up front, from the first corpus positions.
+  const int batchSize = 256;
+  std::vector<Position> positions;
+  for (size_t r = 0; r < corpus().size() && positions.size() < 128 * batchSize;
+       r++) {
+    PositionStream::landed(corpus()[r], positions);
+  }
+  std::vector<BoardBatch> batches(positions.size() / batchSize);
+  for (size_t i = 0; i < batches.size() * batchSize; i++) {
+    batches[i / batchSize].add(positions[i].field, positions[i].tetromino);
+  }
+  BatchFeatures features;
+  size_t i = 0;
+  int64_t before = numAllocations;
+  for (auto _ : state) {
+    evaluateBatch(batches[i++ % batches.size()], features, level);
+    benchmark::DoNotOptimize(features.holes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_EvaluateBatch)->DenseRange(0, 2);
+
+// ____________________________________________________________________________
+static void BM_BotPlayPiece(benchmark::State &state) {
+  Bot bot;
+  GameState game(1, RandomizerMode::Bag);
+  int64_t before = numAllocations;
+  int64_t evaluatedBefore = bot.placementsEvaluated();
+  for (auto _ : state) {
+    if (game.gameOver) {
+      game = GameState(game.piecesPlaced, RandomizerMode::Bag);
+    }
+    bot.playPiece(game);
+  }
+  state.counters["placements/s"] =
+      benchmark::Counter(bot.placementsEvaluated() - evaluatedBefore,
+                         benchmark::Counter::kIsRate);
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_BotPlayPiece);
+
+// ____________________________________________________________________________
+// Perfect clears from the empty field for 10-piece 7-bag queues (about half
+// of them are solvable), one query per iteration. The argument is the number
+// of threads.
+static void BM_PerfectClear(benchmark::State &state) {
+  std::vector<std::vector<int>> queues;
+  for (uint64_t seed = 1; seed <= 32; seed++) {
+    Tetrominos tetrominos(seed, RandomizerMode::Bag, 10);
+    queues.emplace_back();
+    for (int i = 0; i < 10; i++) {
+      queues.back().push_back(tetrominos.peek(i));
+    }
+  }
+  PerfectClearOptions options;
+  options.numThreads = state.range(0);
+  PerfectClearSolver solver(options);
+  Board empty;
+  size_t i = 0;
+  int64_t nodes = 0;
+  for (auto _ : state) {
+    nodes += solver.solve(empty, queues[i++ % queues.size()]).nodes;
+  }
+  state.counters["nodes/s"] =
+      benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PerfectClear)
+    ->Arg(1)
+    ->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  // Load the corpus up front, so the context printed before the results
+  // names it.
+  corpus();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
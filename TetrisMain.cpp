@@ -0,0 +1,278 @@
+#include "./Bot.h"
+#include "./FrameStats.h"
+#include "./Game.h"
+#include "./RenderThread.h"
+#include "./Replay.h"
+#include "./Spectator.h"
+#include "./TerminalManager.h"
+#include "./Tetris.h"
+#include "./Tetromino.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main(int argc, char **argv) {
+  // Mit --autoplay spielt der Bot, Escape beendet das Spiel weiterhin, mit
+  // --lookahead schaut er so viele Steine voraus. Mit --bag kommen die Steine
+  // aus einem 7-Bag, mit --seed ist die Folge fest.
+  // Mit --record wird das Spiel aufgezeichnet (siehe Replay.h). --stats zeigt
+  // die Zeiten der einzelnen Phasen neben dem Feld an, --stats-csv schreibt
+  // sie beim Beenden in eine Datei. --das und --arr stellen das Verhalten
+  // gehaltener Tasten ein (in Frames, siehe RepeatSettings). Mit --ansi wird
+  // ohne ncurses gezeichnet (siehe TerminalBackend), mit --render-thread in
+  // einem eigenen Thread (siehe RenderThread). Mit --spectate können andere
+  // über den gegebenen Socket zuschauen (siehe SpectatorMain).
+  bool autoplay = false;
+  bool showStats = false;
+  bool renderInThread = false;
+  TerminalBackend backend = TerminalBackend::Ncurses;
+  std::string recordPath;
+  std::string statsPath;
+  std::string spectatePath;
+  RepeatSettings repeatSettings;
+  int lookahead = 0;
+  RandomizerMode randomizer = RandomizerMode::Classic;
+  uint64_t seed = std::time(nullptr);
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--autoplay") {
+      autoplay = true;
+    } else if (std::string(argv[i]) == "--bag") {
+      randomizer = RandomizerMode::Bag;
+    } else if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::string(argv[i]) == "--record" && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (std::string(argv[i]) == "--lookahead" && i + 1 < argc) {
+      lookahead = std::atoi(argv[++i]);
+    } else if (std::string(argv[i]) == "--das" && i + 1 < argc) {
+      repeatSettings.das = std::atoi(argv[++i]);
+    } else if (std::string(argv[i]) == "--arr" && i + 1 < argc) {
+      repeatSettings.arr = std::atoi(argv[++i]);
+    } else if (std::string(argv[i]) == "--stats") {
+      showStats = true;
+    } else if (std::string(argv[i]) == "--stats-csv" && i + 1 < argc) {
+      statsPath = argv[++i];
+    } else if (std::string(argv[i]) == "--ansi") {
+      backend = TerminalBackend::Ansi;
+    } else if (std::string(argv[i]) == "--render-thread") {
+      renderInThread = true;
+    } else if (std::string(argv[i]) == "--spectate" && i + 1 < argc) {
+      spectatePath = argv[++i];
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--autoplay] [--lookahead N] [--bag] [--seed S]"
+                   " [--record FILE]"
+                   " [--das N] [--arr N] [--stats] [--stats-csv FILE]"
+                   " [--ansi] [--render-thread] [--spectate SOCKET]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Vor dem Terminal angelegt: Ein Fehler (z.B. ein falscher Pfad) lässt das
+  // Terminal so, wie es war.
+  std::unique_ptr<SpectatorServer> spectators;
+  if (!spectatePath.empty()) {
+    SpectatorServerOptions options;
+    options.socketPath = spectatePath;
+    try {
+      spectators = std::make_unique<SpectatorServer>(options);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  GameState state(seed, randomizer, std::max(1, lookahead - 1));
+  std::unique_ptr<ReplayWriter> recorder;
+  if (!recordPath.empty()) {
+    try {
+      recorder = std::make_unique<ReplayWriter>(recordPath, seed, state);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  // Die Statistik einmal leer schreiben, damit ein falscher Pfad auffällt,
+  // bevor das Terminal übernommen wird.
+  FrameStats stats;
+  if (!statsPath.empty()) {
+    try {
+      stats.writeCsv(statsPath);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  // Ein Fehler während des Spiels (z.B. beim Schreiben der Aufzeichnung)
+  // beendet es. Beim `catch` ist alles im `try` abgebaut, das Terminal also
+  // wiederhergestellt, und die Meldung bleibt sichtbar.
+  try {
+    TerminalManager terminal(gameColors(), backend);
+
+    FrameClock frameClock;
+    std::unique_ptr<TranspositionTable> table;
+    if (lookahead > 0) {
+      table = std::make_unique<TranspositionTable>();
+    }
+    Bot bot(BotWeights(), lookahead, table.get());
+    InputRepeater repeater(repeatSettings);
+    std::vector<Action> inputBatch;
+    auto applyBatch = [&]() {
+      for (Action action : inputBatch) {
+        if (action != Action::None && !state.gameOver &&
+            applyAction(state, action) && recorder) {
+          recorder->record(state.frame, action);
+        }
+      }
+      inputBatch.clear();
+    };
+    bool measure = showStats || !statsPath.empty();
+    int64_t statsDrawnFrame = 0;
+    int64_t framesDrawn = 0;
+    int flushedFor = 0;
+    bool exitRequested = false;
+    FrameSnapshot snapshot;
+    GameView view;
+    // Nach `terminal` angelegt, wird also vorher beendet.
+    std::unique_ptr<RenderThread> renderThread;
+    if (renderInThread) {
+      renderThread = std::make_unique<RenderThread>(terminal);
+    }
+    while (!exitRequested && !state.gameOver) {
+      // Schlafen, bis eine Taste gedrückt wird oder der nächste Frame fällig
+      // ist.
+      bool inputReady = terminal.waitForInput(frameClock.timeUntilNextFrame());
+      if (measure) {
+        stats.startFrame();
+      }
+      bool inputRead = false;
+      for (UserInput userinput = terminal.getUserInput(); !userinput.isNone();
+           userinput = terminal.getUserInput()) {
+        inputRead = true;
+        if (userinput.isEscape()) {
+          exitRequested = true;
+        }
+        if (!autoplay) {
+          repeater.keyEvent(actionFromInput(userinput), state.frame,
+                            inputBatch);
+        }
+      }
+      if (measure) {
+        stats.lap(FramePhase::Input);
+      }
+
+      // Alle Eingaben seit dem letzten Durchlauf werden der Reihe nach sofort
+      // ausgeführt und danach einmal gezeichnet, unabhängig davon, wie schnell
+      // die Tasten kommen. Die Spiellogik selbst läuft in festen Frames, vor
+      // jedem Frame kommen die Wiederholungen gehaltener Tasten dazu.
+      bool inputApplied = !inputBatch.empty();
+      applyBatch();
+      int dueFrames = frameClock.takeDueFrames();
+      if (dueFrames == 0 && !inputApplied) {
+        if (inputReady && !inputRead) {
+          // Eingaben liegen an, aber ncurses zeichnet gerade im Render-Thread.
+          // Kurz warten statt sofort wieder nachzusehen.
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        continue;
+      }
+      for (int i = 0; i < dueFrames && !state.gameOver; i++) {
+        if (autoplay) {
+          inputBatch.push_back(bot.nextAction(state));
+        } else {
+          repeater.tick(state.frame, inputBatch);
+        }
+        applyBatch();
+        step(state, Action::None);
+      }
+      if (recorder && state.piecesPlaced != flushedFor) {
+        recorder->flush();
+        flushedFor = state.piecesPlaced;
+      }
+      if (measure) {
+        stats.lap(FramePhase::Logic);
+      }
+
+      // Die Statistik zweimal pro Sekunde unter der Vorschau aktualisieren.
+      if (showStats && state.frame - statsDrawnFrame >= FRAMES_PER_SECOND / 2) {
+        int line = 0;
+        for (; line < FrameStats::kOverlayLines; line++) {
+          snapshot.setText(line, stats.overlayLine(line));
+        }
+        if (renderThread) {
+          framesDrawn = renderThread->framesDrawn();
+          snapshot.setText(line++,
+                           "Skipped/dropped: " +
+                               std::to_string(renderThread->framesSkipped()) +
+                               "/" +
+                               std::to_string(renderThread->framesDropped()));
+        }
+        if (backend == TerminalBackend::Ansi && framesDrawn > 0) {
+          // Nur das ANSI-Backend weiß, wie viel ans Terminal ging.
+          snapshot.setText(line++, "Bytes/frame: " +
+                                       std::to_string(terminal.bytesWritten() /
+                                                      framesDrawn) +
+                                       "   ");
+        }
+        if (spectators) {
+          snapshot.setText(line++,
+                           "Viewers: " + std::to_string(spectators->viewers()) +
+                               " (" + std::to_string(spectators->resyncs()) +
+                               " resyncs)   ");
+        }
+        snapshot.numTextLines = line;
+        snapshot.textVersion++;
+        statsDrawnFrame = state.frame;
+      }
+      if (measure) {
+        stats.startFrame();
+      }
+      snapshot.capture(state);
+      if (spectators) {
+        spectators->publish(snapshot);
+      }
+      if (measure) {
+        stats.lap(FramePhase::Compose);
+      }
+      // Mit dem Render-Thread wartet die Hauptschleife nie auf das Terminal.
+      if (renderThread) {
+        renderThread->publish(snapshot);
+      } else if (view.draw(terminal, snapshot)) {
+        framesDrawn++;
+      }
+      if (measure) {
+        stats.lap(FramePhase::Draw);
+        stats.frameDrawn();
+      }
+    }
+
+    if (recorder) {
+      recorder->finish(state);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (!statsPath.empty()) {
+    try {
+      stats.writeCsv(statsPath);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
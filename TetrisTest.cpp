@@ -1 +1,1408 @@
+#include "./AnsiScreen.h"
+#include "./BatchEvaluator.h"
+#include "./Board.h"
+#include "./Bot.h"
+#include "./Corpus.h"
+#include "./FrameStats.h"
+#include "./Game.h"
+#include "./PerfectClear.h"
+#include "./Placement.h"
+#include "./Replay.h"
+#include "./SelfPlay.h"
+#include "./Spectator.h"
+#include "./SpscQueue.h"
+#include "./Tetris.h"
+#include "./Tetromino.h"
+#include "./TrainingExport.h"
+#include "./Versus.h"
+#include "./VersusServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
 
+// Fills a row of the board completely, except for the columns in `gaps`.
+static void fillRow(Board &board, int row, std::initializer_list<int> gaps) {
+  for (int col = 0; col < Board::kWidth; col++) {
+    board.setCell(row, col, 1);
+  }
+  for (int col : gaps) {
+    board.setCell(row, col, 0);
+  }
+}
+
+TEST(BoardTest, fits) {
+  Board board;
+  const Board::Row square[] = {0b11, 0b11};
+  ASSERT_TRUE(board.fits(square, 2, 2, 0, 0));
+  ASSERT_TRUE(board.fits(square, 2, 2, 18, 8));
+  ASSERT_FALSE(board.fits(square, 2, 2, -1, 0));
+  ASSERT_FALSE(board.fits(square, 2, 2, 0, -1));
+  ASSERT_FALSE(board.fits(square, 2, 2, 19, 0));
+  ASSERT_FALSE(board.fits(square, 2, 2, 0, 9));
+  board.setCell(5, 5, 3);
+  ASSERT_FALSE(board.fits(square, 2, 2, 4, 4));
+  ASSERT_TRUE(board.fits(square, 2, 2, 4, 6));
+}
+
+TEST(BoardTest, place) {
+  Board board;
+  const Board::Row tShape[] = {0b111, 0b010};
+  board.place(tShape, 2, 18, 3, 4);
+  ASSERT_EQ(board.getRow(18), 0b111 << 3);
+  ASSERT_EQ(board.getRow(19), 0b010 << 3);
+  ASSERT_EQ(board.getColor(18, 3), 4);
+  ASSERT_EQ(board.getColor(19, 4), 4);
+  ASSERT_EQ(board.getColor(19, 3), 0);
+  ASSERT_TRUE(board.isOccupied(18, 5));
+  ASSERT_FALSE(board.isOccupied(19, 5));
+}
+
+TEST(BoardTest, clearFullLines) {
+  Board board;
+  fillRow(board, 19, {});
+  fillRow(board, 18, {4});
+  fillRow(board, 17, {});
+  board.setCell(16, 2, 7);
+  ASSERT_EQ(board.clearFullLines(), 2);
+  ASSERT_EQ(board.getRow(19), Board::kFullRow & ~(1 << 4));
+  ASSERT_EQ(board.getRow(18), 1 << 2);
+  ASSERT_EQ(board.getColor(18, 2), 7);
+  ASSERT_EQ(board.getRow(17), 0);
+  ASSERT_EQ(board.clearFullLines(), 0);
+}
+
+// The same board operations on every board size, up to 64 columns where the
+// rightmost column is the top bit of the row.
+template <class B> class BoardSizesTest : public ::testing::Test {};
+using BoardSizes = ::testing::Types<Board, TallBoard, WideBoard, HugeBoard>;
+TYPED_TEST_SUITE(BoardSizesTest, BoardSizes);
+
+TYPED_TEST(BoardSizesTest, placeClearAndHash) {
+  using B = TypeParam;
+  const int bottom = B::kHeight - 1;
+  const int right = B::kWidth - 4;
+  const PieceMask iShape[] = {0b1111};
+  const uint8_t iBottoms[] = {0, 0, 0, 0};
+  B board;
+  ASSERT_EQ(board.landingRow(iShape, iBottoms, 1, 4, 0, right), bottom);
+  ASSERT_FALSE(board.fits(iShape, 1, 4, 0, right + 1));
+
+  // Fill the bottom row up to the I at the right wall.
+  for (int col = 0; col < right; col++) {
+    board.setCell(bottom, col, 2);
+  }
+  board.setCell(bottom - 1, 0, 3);
+  uint64_t hashBefore = board.hash();
+  board.place(iShape, 1, bottom, right, 5);
+  ASSERT_EQ(board.getRow(bottom), B::kFullRow);
+  ASSERT_EQ(board.getColor(bottom, B::kWidth - 1), 5);
+  ASSERT_EQ(board.columnHeight(B::kWidth - 1), 1);
+  ASSERT_NE(board.hash(), hashBefore);
+
+  ASSERT_EQ(board.clearFullLines(), 1);
+  ASSERT_EQ(board.getRow(bottom), 1u);
+  ASSERT_EQ(board.getColor(bottom, 0), 3);
+  ASSERT_EQ(board.columnHeight(0), 1);
+  ASSERT_EQ(board.columnHeight(B::kWidth - 1), 0);
+  B rebuilt;
+  rebuilt.setCell(bottom, 0, 3);
+  ASSERT_EQ(board.hash(), rebuilt.hash());
+
+  // Garbage with the hole in the last column.
+  ASSERT_TRUE(board.addGarbage(2, B::kWidth - 1, 8));
+  ASSERT_EQ(board.getRow(bottom), B::kFullRow >> 1);
+  ASSERT_EQ(board.getRow(bottom - 2), 1u);
+  ASSERT_EQ(board.columnHeight(0), 3);
+  ASSERT_EQ(board.columnHeight(B::kWidth - 1), 0);
+}
+
+// The features of `board`, computed from scratch cell by cell.
+template <class B> typename B::Features referenceFeatures(const B &board) {
+  typename B::Features features;
+  int heights[B::kWidth];
+  for (int col = 0; col < B::kWidth; col++) {
+    heights[col] = 0;
+    for (int row = B::kHeight - 1; row >= 0; row--) {
+      if (board.isOccupied(row, col)) {
+        heights[col] = B::kHeight - row;
+      }
+    }
+    for (int row = B::kHeight - heights[col]; row < B::kHeight; row++) {
+      features.holes += !board.isOccupied(row, col);
+    }
+    features.aggregateHeight += heights[col];
+  }
+  for (int col = 0; col < B::kWidth; col++) {
+    int left = col > 0 ? heights[col - 1] : B::kHeight;
+    int right = col + 1 < B::kWidth ? heights[col + 1] : B::kHeight;
+    features.wellDepth += std::max(0, std::min(left, right) - heights[col]);
+    if (col + 1 < B::kWidth) {
+      features.bumpiness += std::abs(heights[col] - heights[col + 1]);
+    }
+  }
+  for (int row = 0; row < B::kHeight; row++) {
+    if (board.getRow(row) == 0) {
+      continue;
+    }
+    bool last = true;
+    for (int col = 0; col <= B::kWidth; col++) {
+      bool occupied = col == B::kWidth || board.isOccupied(row, col);
+      features.rowTransitions += occupied != last;
+      last = occupied;
+    }
+  }
+  return features;
+}
+
+template <class Features>
+static void expectSameFeatures(const Features &a, const Features &b) {
+  ASSERT_EQ(a.aggregateHeight, b.aggregateHeight);
+  ASSERT_EQ(a.holes, b.holes);
+  ASSERT_EQ(a.bumpiness, b.bumpiness);
+  ASSERT_EQ(a.rowTransitions, b.rowTransitions);
+  ASSERT_EQ(a.wellDepth, b.wellDepth);
+}
+
+TYPED_TEST(BoardSizesTest, featuresFollowEveryChangeAndUndo) {
+  using B = TypeParam;
+  Random random(B::kWidth * 1000 + B::kHeight);
+  B board;
+  typename B::Undo undo;
+  for (int step = 0; step < 2000; step++) {
+    // A random piece dropped in a random column, sometimes with a stray cell
+    // or a garbage row to make holes.
+    if (random.below(10) == 0) {
+      board.setCell(random.below(B::kHeight / 2) + B::kHeight / 2,
+                    random.below(B::kWidth), random.below(2));
+      board.clearFullLines();
+    }
+    if (random.below(50) == 0) {
+      board.addGarbage(1, random.below(B::kWidth), 8);
+    }
+    const PieceType &type = PIECES[random.below(NUM_PIECES)];
+    const PieceRotation &shape =
+        type.rotations[random.below(type.numRotations)];
+    int col = random.below(B::kWidth - shape.width + 1);
+    if (!board.fits(shape.rows, shape.height, shape.width, 0, col)) {
+      board = B();
+      continue;
+    }
+    expectSameFeatures(board.features(), referenceFeatures(board));
+    int row = board.landingRow(shape.rows, shape.bottoms, shape.height,
+                               shape.width, 0, col);
+    int expectedLines;
+    typename B::Features expected = board.featuresAfter(
+        shape.rows, shape.height, shape.width, row, col, &expectedLines);
+
+    B before = board;
+    board.place(shape.rows, shape.height, row, col, type.color, &undo);
+    int lines = board.clearFullLines(nullptr, &undo);
+    ASSERT_EQ(lines, expectedLines);
+    expectSameFeatures(board.features(), expected);
+    expectSameFeatures(board.features(), referenceFeatures(board));
+
+    // Every fourth placement is taken back.
+    if (step % 4 == 0) {
+      board.undo(undo);
+      ASSERT_EQ(board.getRows(), before.getRows());
+      ASSERT_EQ(board.hash(), before.hash());
+      for (int c = 0; c < B::kWidth; c++) {
+        ASSERT_EQ(board.columnHeight(c), before.columnHeight(c));
+        ASSERT_EQ(board.getColor(B::kHeight - 1, c),
+                  before.getColor(B::kHeight - 1, c));
+      }
+      expectSameFeatures(board.features(), before.features());
+    } else {
+      undo = typename B::Undo();
+    }
+  }
+}
+
+TEST(BoardTest, columnHeightsAndLanding) {
+  Board board;
+  const Board::Row tShape[] = {0b111, 0b010};
+  const uint8_t tBottoms[] = {0, 1, 0};
+  ASSERT_EQ(board.landingRow(tShape, tBottoms, 2, 3, 0, 3), 18);
+  board.place(tShape, 2, 18, 3, 4);
+  ASSERT_EQ(board.columnHeight(2), 0);
+  ASSERT_EQ(board.columnHeight(3), 2);
+  ASSERT_EQ(board.columnHeight(4), 2);
+  // Resting on the T, and one column to the right on the T's arm.
+  ASSERT_EQ(board.landingRow(tShape, tBottoms, 2, 3, 0, 3), 16);
+  ASSERT_EQ(board.landingRow(tShape, tBottoms, 2, 3, 0, 5), 17);
+  // Under the overhang of the T the heights do not help.
+  const Board::Row dot[] = {0b1};
+  const uint8_t dotBottoms[] = {0};
+  ASSERT_EQ(board.landingRow(dot, dotBottoms, 1, 1, 19, 3), 19);
+
+  // Clearing a line can uncover holes, the heights follow.
+  fillRow(board, 19, {4});
+  board.setCell(18, 3, 0);
+  board.setCell(18, 5, 0);
+  ASSERT_EQ(board.columnHeight(3), 1);
+  ASSERT_EQ(board.columnHeight(4), 2);
+  ASSERT_EQ(board.clearFullLines(), 0);
+  board.setCell(19, 4, 1);
+  board.setCell(18, 4, 0);
+  ASSERT_EQ(board.clearFullLines(), 1);
+  for (int col = 0; col < Board::kWidth; col++) {
+    ASSERT_EQ(board.columnHeight(col), 0);
+  }
+}
+
+TEST(TetrominoTest, moveAndPlace) {
+  Board board;
+  Tetromino square(PIECE_O);
+  ASSERT_EQ(square.getPosition(), std::make_pair(0, 4));
+  square.setPosition(0, 8);
+  ASSERT_FALSE(square.move(1, 0, board));
+  ASSERT_TRUE(square.move(-1, 0, board));
+  while (square.move(0, 1, board)) {
+  }
+  ASSERT_EQ(square.getPosition(), std::make_pair(18, 7));
+  placeTetrominoInField(board, square);
+  ASSERT_EQ(board.getColor(19, 8), 6);
+  square.setPosition(0, 7);
+  ASSERT_TRUE(square.move(0, 1, board));
+  ASSERT_FALSE(square.move(0, 16, board));
+}
+
+TEST(TetrominoTest, pieceTables) {
+  ASSERT_EQ(PIECES[PIECE_I].numRotations, 2);
+  ASSERT_EQ(PIECES[PIECE_I].spawnCol, 3);
+  ASSERT_EQ(PIECES[PIECE_T].rotations[1].height, 3);
+  ASSERT_EQ(PIECES[PIECE_T].rotations[1].width, 2);
+  ASSERT_EQ(PIECES[PIECE_T].rotations[1].rows[1], 0b11);
+  ASSERT_EQ(PIECES[PIECE_S].rotations[0].rows[0], 0b110);
+  Board board;
+  Tetromino t(PIECE_T);
+  t.rotateClockwise(board);
+  ASSERT_EQ(t.getRotation(), 1);
+  t.rotateCounterClockwise(board);
+  t.rotateCounterClockwise(board);
+  ASSERT_EQ(t.getRotation(), 3);
+  ASSERT_EQ(t.getColor(), 3);
+}
+
+TEST(GameTest, actionsAndLocking) {
+  GameState state;
+  state.currentTetromino = Tetromino(PIECE_O);
+  state.nextTetromino = Tetromino(PIECE_I);
+  ASSERT_TRUE(applyAction(state, Action::Left));
+  ASSERT_EQ(state.currentTetromino.getPosition(), std::make_pair(0, 3));
+  ASSERT_FALSE(applyAction(state, Action::RotateClockwise));
+  for (int i = 0; i < 18; i++) {
+    ASSERT_TRUE(applyAction(state, Action::SoftDrop));
+  }
+  ASSERT_EQ(state.piecesPlaced, 0);
+  ASSERT_TRUE(applyAction(state, Action::SoftDrop));
+  ASSERT_EQ(state.piecesPlaced, 1);
+  ASSERT_TRUE(state.field.isOccupied(19, 3));
+  ASSERT_EQ(state.currentTetromino.getPiece(), PIECE_I);
+}
+
+TEST(GameTest, hardDrop) {
+  GameState state;
+  state.currentTetromino = Tetromino(PIECE_I);
+  state.nextTetromino = Tetromino(PIECE_O);
+  ASSERT_EQ(state.currentTetromino.landingRow(state.field), 19);
+  ASSERT_TRUE(applyAction(state, Action::HardDrop));
+  ASSERT_EQ(state.piecesPlaced, 1);
+  ASSERT_EQ(state.field.getRow(19), 0b1111 << 3);
+  ASSERT_EQ(state.currentTetromino.getPiece(), PIECE_O);
+  ASSERT_EQ(state.currentTetromino.landingRow(state.field), 17);
+}
+
+TEST(GameTest, gravityAndGameOver) {
+  GameState state;
+  ASSERT_EQ(state.framesPerRow, 48);
+  for (int i = 0; i < 47; i++) {
+    step(state, Action::None);
+  }
+  ASSERT_EQ(state.currentTetromino.getPosition().first, 0);
+  step(state, Action::None);
+  ASSERT_EQ(state.currentTetromino.getPosition().first, 1);
+  // Without input the pieces pile up in the middle until the game ends.
+  while (!state.gameOver) {
+    step(state, Action::None);
+  }
+  ASSERT_GT(state.piecesPlaced, 4);
+  ASSERT_EQ(state.totalLinesCleared, 0);
+  int64_t frame = state.frame;
+  step(state, Action::None);
+  ASSERT_EQ(state.frame, frame);
+}
+
+TEST(GameTest, tSpinComboAndBackToBack) {
+  // A T slot with an overhang: the T can only rotate into it in place.
+  auto setUp = [](GameState &state, bool overhangRight) {
+    fillRow(state.field, 19, {4});
+    fillRow(state.field, 18, {3, 4, 5});
+    state.field.setCell(17, 3, 1);
+    if (overhangRight) {
+      state.field.setCell(17, 5, 1);
+    }
+    state.currentTetromino = Tetromino(PIECE_T, 1, 17, 3);
+    state.nextTetromino = Tetromino(PIECE_I);
+  };
+
+  GameState state(1);
+  setUp(state, true);
+  ASSERT_TRUE(applyAction(state, Action::RotateClockwise));
+  ASSERT_TRUE(applyAction(state, Action::HardDrop));
+  const ClearEvent &event = state.lastClear;
+  ASSERT_EQ(event.lines, 1);
+  ASSERT_TRUE(event.rows.test(18));
+  ASSERT_EQ(event.rows.count(), 1u);
+  ASSERT_EQ(event.tSpin, TSpin::Full);
+  ASSERT_EQ(event.combo, 0);
+  ASSERT_FALSE(event.backToBack);
+  ASSERT_EQ(event.score, 800);
+  ASSERT_EQ(state.score, 800);
+  ASSERT_EQ(state.totalLinesCleared, 1);
+
+  // Only three corners: a mini, and back-to-back after the T-spin above. The
+  // I piece in between clears nothing and does not break back-to-back, but
+  // ends the combo.
+  GameState mini(1);
+  setUp(mini, false);
+  mini.difficultLast = true;
+  mini.lastClear.combo = 3;
+  ASSERT_TRUE(applyAction(mini, Action::RotateClockwise));
+  ASSERT_TRUE(applyAction(mini, Action::SoftDrop));
+  ASSERT_EQ(mini.lastClear.tSpin, TSpin::Mini);
+  ASSERT_TRUE(mini.lastClear.backToBack);
+  ASSERT_EQ(mini.lastClear.combo, 4);
+  ASSERT_EQ(mini.lastClear.score, 200 * 3 / 2 + 50 * 4);
+
+  // The same position without a rotation as the last move is no T-spin.
+  GameState moved(1);
+  setUp(moved, true);
+  moved.currentTetromino = Tetromino(PIECE_T, 2, 17, 3);
+  ASSERT_TRUE(applyAction(moved, Action::HardDrop));
+  ASSERT_EQ(moved.lastClear.lines, 1);
+  ASSERT_EQ(moved.lastClear.tSpin, TSpin::None);
+  ASSERT_EQ(moved.lastClear.score, 100);
+}
+
+TEST(GameTest, scoreTable) {
+  ClearEvent event;
+  ASSERT_EQ(scoreFor(event, 0), 0);
+  event.lines = 4;
+  event.combo = 0;
+  ASSERT_EQ(scoreFor(event, 0), 800);
+  ASSERT_EQ(scoreFor(event, 2), 2400);
+  event.backToBack = true;
+  event.combo = 2;
+  ASSERT_EQ(scoreFor(event, 0), 1200 + 100);
+  ClearEvent tSpin;
+  tSpin.tSpin = TSpin::Full;
+  ASSERT_EQ(scoreFor(tSpin, 0), 400);
+  tSpin.lines = 3;
+  ASSERT_EQ(scoreFor(tSpin, 1), 3200);
+}
+
+TEST(PlacementTest, emptyBoard) {
+  Board board;
+  PlacementGenerator generator;
+  ASSERT_EQ(generator.generate(board, Tetromino(PIECE_O)).size(), 9u);
+  ASSERT_EQ(generator.generate(board, Tetromino(PIECE_I)).size(), 17u);
+  ASSERT_EQ(generator.generate(board, Tetromino(PIECE_T)).size(), 34u);
+  for (const Tetromino &placement : generator.generate(board, Tetromino(0))) {
+    ASSERT_EQ(placement.getPosition().first + placement.getShape().height,
+              Board::kHeight);
+  }
+}
+
+TEST(PlacementTest, pathReachesTarget) {
+  // An overhang at row 17, columns 0-2: the T can only get below it by
+  // sliding in from the right.
+  Board board;
+  for (int col = 0; col < 3; col++) {
+    board.setCell(17, col, 1);
+  }
+  PlacementGenerator generator;
+  Tetromino start(PIECE_T);
+  bool foundTuck = false;
+  for (const Tetromino &placement : generator.generate(board, start)) {
+    if (placement.getPosition() == std::make_pair(18, 0)) {
+      foundTuck = true;
+      GameState state;
+      state.field = board;
+      state.currentTetromino = start;
+      for (Action action : generator.pathTo(placement)) {
+        applyAction(state, action);
+      }
+      ASSERT_EQ(state.piecesPlaced, 1);
+      ASSERT_TRUE(state.field.isOccupied(19, 1));
+    }
+  }
+  ASSERT_TRUE(foundTuck);
+}
+
+TEST(BotTest, computeFeatures) {
+  Board board;
+  board.setCell(19, 0, 1);
+  board.setCell(17, 0, 1);
+  board.setCell(19, 2, 1);
+  BoardFeatures features = computeFeatures(board.getRows().data());
+  ASSERT_EQ(features.aggregateHeight, 4);
+  ASSERT_EQ(features.holes, 1);
+  ASSERT_EQ(features.bumpiness, 3 + 1 + 1);
+  ASSERT_EQ(features.linesCleared, 0);
+}
+
+TEST(BotTest, playGame) {
+  GameState state;
+  Bot bot;
+  playGame(state, bot, 300);
+  ASSERT_FALSE(state.gameOver);
+  ASSERT_EQ(state.piecesPlaced, 300);
+  ASSERT_GT(state.totalLinesCleared, 100);
+  ASSERT_GT(bot.placementsEvaluated(), 300);
+}
+
+TEST(SelfPlayTest, reproducibleAcrossThreadCounts) {
+  SelfPlayOptions options;
+  options.numGames = 12;
+  options.maxPieces = 60;
+  options.numThreads = 1;
+  std::vector<GameResult> single;
+  SelfPlayStats stats = runSelfPlay(options, &single);
+  ASSERT_EQ(stats.numGames, 12);
+  ASSERT_EQ(stats.piecesPlaced, 12 * 60);
+  options.numThreads = 4;
+  std::vector<GameResult> parallel;
+  SelfPlayStats parallelStats = runSelfPlay(options, &parallel);
+  ASSERT_EQ(parallelStats.linesCleared, stats.linesCleared);
+  for (int i = 0; i < 12; i++) {
+    ASSERT_EQ(parallel[i].seed, options.firstSeed + i);
+    ASSERT_EQ(parallel[i].linesCleared, single[i].linesCleared);
+  }
+}
+
+TEST(SelfPlayTest, largerBoards) {
+  SelfPlayOptions options;
+  options.numGames = 4;
+  options.maxPieces = 100;
+  options.numThreads = 2;
+  options.boardWidth = TallBoard::kWidth;
+  options.boardHeight = TallBoard::kHeight;
+  std::vector<GameResult> results;
+  SelfPlayStats stats = runSelfPlay(options, &results);
+  ASSERT_EQ(stats.piecesPlaced, 4 * 100);
+  ASSERT_GT(stats.placementsEvaluated, stats.piecesPlaced);
+  BasicGameState<TallBoard> tall(options.firstSeed);
+  int64_t evaluated = 0;
+  playGreedyGame(tall, options.weights, 100, evaluated);
+  ASSERT_EQ(results[0].linesCleared, tall.totalLinesCleared);
+
+  options.lookahead = 1;
+  ASSERT_THROW(runSelfPlay(options), std::runtime_error);
+  options.lookahead = 0;
+  options.boardWidth = 12;
+  ASSERT_THROW(runSelfPlay(options), std::runtime_error);
+}
+
+// Games on every board size: the pieces spawn in the middle, and the greedy
+// player clears lines even on the widest board.
+TYPED_TEST(BoardSizesTest, greedyGame) {
+  using B = TypeParam;
+  BasicGameState<B> state(7, RandomizerMode::Bag);
+  const Tetromino &spawned = state.currentTetromino;
+  ASSERT_EQ(spawned.getPosition().first, 0);
+  ASSERT_LE(std::abs(2 * spawned.getPosition().second +
+                     spawned.getShape().width - B::kWidth),
+            1);
+  int64_t evaluated = 0;
+  playGreedyGame(state, BotWeights(), 600, evaluated);
+  ASSERT_FALSE(state.gameOver);
+  ASSERT_EQ(state.piecesPlaced, 600);
+  ASSERT_GT(state.totalLinesCleared, 0);
+  ASSERT_GT(evaluated, 600);
+}
+
+TEST(PerfectClearTest, pruningAndSimpleCases) {
+  // Four rows full except for column 9: only a vertical I fits.
+  Board board;
+  for (int row = 16; row < 20; row++) {
+    fillRow(board, row, {9});
+  }
+  PerfectClearOptions options;
+  options.numThreads = 1;
+  PerfectClearSolver solver(options);
+  PerfectClearResult result = solver.solve(board, {PIECE_I});
+  ASSERT_TRUE(result.found);
+  ASSERT_EQ(result.height, 4);
+  ASSERT_EQ(result.placements.size(), 1u);
+  ASSERT_EQ(result.placements[0].getPosition(), std::make_pair(16, 9));
+  ASSERT_FALSE(solver.solve(board, {PIECE_O, PIECE_O}).found);
+
+  // An odd number of empty cells in every height: rejected without search.
+  Board odd;
+  fillRow(odd, 19, {0});
+  result = solver.solve(odd, {PIECE_I, PIECE_T, PIECE_O, PIECE_L, PIECE_J});
+  ASSERT_FALSE(result.found);
+  ASSERT_EQ(result.nodes, 0);
+
+  // Full columns 1 and 9 split the two bottom rows into sections of 2 and 14
+  // empty cells, although 16 cells would be four I pieces.
+  Board split;
+  fillRow(split, 18, {0, 2, 3, 4, 5, 6, 7, 8});
+  fillRow(split, 19, {0, 2, 3, 4, 5, 6, 7, 8});
+  options.height = 2;
+  PerfectClearSolver low(options);
+  result = low.solve(split, {PIECE_I, PIECE_I, PIECE_I, PIECE_I});
+  ASSERT_FALSE(result.found);
+  ASSERT_EQ(result.nodes, 0);
+
+  // Cells above the requested zone.
+  ASSERT_FALSE(low.solve(board, {PIECE_I}).found);
+}
+
+TEST(PerfectClearTest, solutionEmptiesTheBoard) {
+  for (uint64_t seed : {33, 43}) {
+    Tetrominos tetrominos(seed, RandomizerMode::Bag, 10);
+    std::vector<int> queue;
+    for (int i = 0; i < 10; i++) {
+      queue.push_back(tetrominos.peek(i));
+    }
+    PerfectClearOptions options;
+    options.numThreads = 1;
+    PerfectClearResult single = PerfectClearSolver(options).solve({}, queue);
+    ASSERT_TRUE(single.found);
+    ASSERT_EQ(single.height, 4);
+    ASSERT_EQ(single.placements.size(), 10u);
+    options.numThreads = 3;
+    PerfectClearResult parallel = PerfectClearSolver(options).solve({}, queue);
+    ASSERT_TRUE(parallel.found);
+
+    // Every placement is reachable, and the board ends up empty.
+    for (const PerfectClearResult &result : {single, parallel}) {
+      Board board;
+      PlacementGenerator generator;
+      for (size_t i = 0; i < result.placements.size(); i++) {
+        const Tetromino &placement = result.placements[i];
+        ASSERT_EQ(placement.getPiece(), queue[i]);
+        generator.generate(board, Tetromino(queue[i]));
+        ASSERT_FALSE(generator.pathTo(placement).empty());
+        placeTetrominoInField(board, placement);
+        board.clearFullLines();
+      }
+      for (Board::Row row : board.getRows()) {
+        ASSERT_EQ(row, 0);
+      }
+    }
+    for (size_t i = 0; i < single.placements.size(); i++) {
+      ASSERT_EQ(parallel.placements[i].getPosition(),
+                single.placements[i].getPosition());
+      ASSERT_EQ(parallel.placements[i].getRotation(),
+                single.placements[i].getRotation());
+    }
+  }
+}
+
+TEST(TetrominosTest, bagAndPreview) {
+  Tetrominos tetrominos(42, RandomizerMode::Bag, 5);
+  ASSERT_EQ(tetrominos.previewSize(), 5);
+  for (int bag = 0; bag < 3; bag++) {
+    int seen = 0;
+    for (int i = 0; i < NUM_PIECES; i++) {
+      int expected = tetrominos.peek(0);
+      int upcoming = tetrominos.peek(4);
+      Tetromino tetromino = tetrominos.getRandomTetromino();
+      ASSERT_EQ(tetromino.getPiece(), expected);
+      ASSERT_EQ(tetrominos.peek(3), upcoming);
+      seen |= 1 << tetromino.getPiece();
+    }
+    ASSERT_EQ(seen, (1 << NUM_PIECES) - 1);
+  }
+}
+
+TEST(TetrominosTest, sameSeedSameSequence) {
+  for (RandomizerMode mode : {RandomizerMode::Classic, RandomizerMode::Bag}) {
+    Tetrominos a(7, mode);
+    Tetrominos b(7, mode);
+    Tetrominos c(8, mode);
+    bool differs = false;
+    for (int i = 0; i < 100; i++) {
+      int piece = a.getRandomTetromino().getPiece();
+      ASSERT_EQ(piece, b.getRandomTetromino().getPiece());
+      differs |= piece != c.getRandomTetromino().getPiece();
+    }
+    ASSERT_TRUE(differs);
+  }
+}
+
+TEST(ReplayTest, recordAndVerify) {
+  const std::string path = "TetrisTest.replay.tmp";
+  GameState state(1234, RandomizerMode::Bag);
+  {
+    // Let the bot play in real time for a while, like --autoplay does.
+    ReplayWriter writer(path, 1234, state);
+    Bot bot;
+    while (!state.gameOver && state.frame < 20000) {
+      Action action = bot.nextAction(state);
+      if (action != Action::None) {
+        applyAction(state, action);
+        writer.record(state.frame, action);
+      }
+      step(state, Action::None);
+    }
+    writer.finish(state);
+  }
+  ASSERT_GT(state.piecesPlaced, 100);
+
+  ReplayReader reader(path);
+  ASSERT_EQ(reader.seed(), 1234u);
+  ASSERT_EQ(reader.mode(), RandomizerMode::Bag);
+  GameState replayed;
+  ReplayOutcome outcome = simulateReplay(reader, &replayed);
+  ASSERT_TRUE(reader.isComplete());
+  ASSERT_TRUE(outcome.matches(reader.recordedOutcome()));
+  ASSERT_EQ(outcome.frames, state.frame);
+  ASSERT_EQ(outcome.linesCleared, state.totalLinesCleared);
+  ASSERT_EQ(replayed.field.getRows(), state.field.getRows());
+  std::remove(path.c_str());
+}
+
+TEST(TrainingExportTest, roundTripFollowsTheGame) {
+  const std::string path = "TetrisTest.training.tmp";
+  for (bool compress : {false, true}) {
+    GameState state(99, RandomizerMode::Bag);
+    {
+      // Small blocks, so that the game spans several of them.
+      TrainingWriterOptions options;
+      options.blockSamples = 100;
+      options.compress = compress;
+      TrainingWriter writer(path, options);
+      DecisionLog log(writer);
+      Bot bot;
+      log.begin(state);
+      while (!state.gameOver && state.piecesPlaced < 1000) {
+        for (Action action : bot.planMoves(state)) {
+          applyAction(state, action);
+          log.observe(state);
+        }
+      }
+      log.flush();
+      writer.finish();
+      ASSERT_EQ(writer.samplesWritten(), state.piecesPlaced);
+    }
+
+    // Placing each piece on its board must give the board of the next sample.
+    TrainingReader reader(path);
+    std::vector<TrainingSample> block;
+    Board field;
+    int samples = 0;
+    int lines = 0;
+    while (reader.nextBlock(block)) {
+      ASSERT_LE(block.size(), 100u);
+      for (const TrainingSample &sample : block) {
+        ASSERT_EQ(sample.unpackBoard(), field.getRows());
+        Tetromino piece(sample.piece, sample.rotation, sample.row, sample.col);
+        placeTetrominoInField(field, piece);
+        ASSERT_EQ(field.clearFullLines(), sample.linesCleared);
+        lines += sample.linesCleared;
+        samples++;
+        TrainingSample packed = sample;
+        packed.packBoard(field);
+        ASSERT_EQ(packed.unpackBoard(), field.getRows());
+      }
+    }
+    ASSERT_EQ(samples, state.piecesPlaced);
+    ASSERT_EQ(lines, state.totalLinesCleared);
+    ASSERT_EQ(field.getRows(), state.field.getRows());
+  }
+  std::remove(path.c_str());
+}
+
+TEST(TrainingExportTest, corruptBlocksAreRejected) {
+  const std::string path = "TetrisTest.corrupt.tmp";
+  for (bool compress : {false, true}) {
+    {
+      TrainingWriterOptions options;
+      options.compress = compress;
+      TrainingWriter writer(path, options);
+      std::vector<TrainingSample> samples(50);
+      writer.append(samples.data(), samples.size());
+      writer.finish();
+    }
+    // A block size far beyond the end of the file.
+    std::FILE *file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, 16 + 8, SEEK_SET);
+    const uint8_t huge[4] = {0xff, 0xff, 0xff, 0x7f};
+    std::fwrite(huge, 1, 4, file);
+    std::fclose(file);
+    {
+      TrainingReader reader(path);
+      std::vector<TrainingSample> block;
+      ASSERT_THROW(reader.nextBlock(block), std::runtime_error);
+    }
+    // A block header cut off in the middle.
+    ASSERT_EQ(truncate(path.c_str(), 16 + 6), 0);
+    TrainingReader reader(path);
+    std::vector<TrainingSample> block;
+    ASSERT_THROW(reader.nextBlock(block), std::runtime_error);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(TrainingExportTest, selfPlayExportsEveryPiece) {
+  SelfPlayOptions options;
+  options.numGames = 6;
+  options.numThreads = 2;
+  options.maxPieces = 300;
+  options.exportPath = "TetrisTest.selfplay.tmp";
+  SelfPlayStats stats = runSelfPlay(options);
+  ASSERT_EQ(stats.samplesExported, stats.piecesPlaced);
+
+  TrainingReader reader(options.exportPath);
+  std::vector<TrainingSample> block;
+  int64_t samples = 0;
+  int gamesOver = 0;
+  while (reader.nextBlock(block)) {
+    samples += block.size();
+    for (const TrainingSample &sample : block) {
+      gamesOver += sample.gameOver;
+    }
+  }
+  ASSERT_EQ(samples, stats.piecesPlaced);
+  ASSERT_EQ(gamesOver, stats.gamesOver);
+  std::remove(options.exportPath.c_str());
+}
+
+// Checks that a decoded spectator frame shows the same game as `state`.
+static void expectSameFrame(const FrameSnapshot &shown,
+                            const GameState &state) {
+  ASSERT_EQ(shown.frame, state.frame);
+  ASSERT_EQ(shown.score, state.score);
+  ASSERT_EQ(shown.linesCleared, state.totalLinesCleared);
+  ASSERT_EQ(shown.piecesPlaced, state.piecesPlaced);
+  ASSERT_EQ(shown.current.getPiece(), state.currentTetromino.getPiece());
+  ASSERT_EQ(shown.current.getRotation(),
+            state.currentTetromino.getRotation());
+  ASSERT_EQ(shown.current.getPosition(),
+            state.currentTetromino.getPosition());
+  ASSERT_EQ(shown.next.getPiece(), state.nextTetromino.getPiece());
+  for (int row = 0; row < Board::kHeight; row++) {
+    for (int col = 0; col < Board::kWidth; col++) {
+      ASSERT_EQ(shown.field.getColor(row, col), state.field.getColor(row, col));
+    }
+  }
+}
+
+TEST(CorpusTest, reproducibleAndMappedAsWritten) {
+  const std::string path = "TetrisTest.corpus.tmp";
+  CorpusOptions options;
+  options.numPositions = 500;
+  options.maxPieces = 150;
+  options.numThreads = 1;
+  std::vector<CorpusRecord> records = generateCorpus(options);
+  ASSERT_EQ(records.size(), 500u);
+  options.numThreads = 3;
+  std::vector<CorpusRecord> parallel = generateCorpus(options);
+  ASSERT_EQ(std::memcmp(records.data(), parallel.data(),
+                        records.size() * sizeof(CorpusRecord)),
+            0);
+
+  // Games that all end before the skipped pieces give no positions at all.
+  CorpusOptions hopeless;
+  hopeless.numPositions = 10;
+  hopeless.skipPieces = 500;
+  hopeless.randomPercent = 100;
+  hopeless.numThreads = 1;
+  ASSERT_THROW(generateCorpus(hopeless), std::runtime_error);
+
+  // Every position is one of a running game: no full rows, the piece fits.
+  for (size_t i = 0; i < records.size(); i++) {
+    const CorpusRecord &record = records[i];
+    Board field;
+    record.loadField(field);
+    Board expected;
+    for (int row = 0; row < Board::kHeight; row++) {
+      ASSERT_NE(field.getRow(row), Board::kFullRow);
+      for (int col = 0; col < Board::kWidth; col++) {
+        if ((record.rows[row] >> col) & 1) {
+          expected.setCell(row, col, 1);
+        }
+      }
+    }
+    ASSERT_EQ(field.getRows(), expected.getRows());
+    ASSERT_EQ(field.hash(), expected.hash());
+    expectSameFeatures(field.features(), referenceFeatures(field));
+    Tetromino tetromino = record.tetromino();
+    ASSERT_TRUE(tetromino.move(0, 0, field));
+    ASSERT_GE(record.piecesPlaced, static_cast<uint32_t>(options.skipPieces));
+    ASSERT_LT(record.piecesPlaced, static_cast<uint32_t>(options.maxPieces));
+    if (i > 0) {
+      ASSERT_GE(record.seed, records[i - 1].seed);
+    }
+  }
+
+  writeCorpus(path, options, records);
+  {
+    Corpus corpus(path);
+    ASSERT_EQ(corpus.size(), records.size());
+    ASSERT_EQ(corpus.header().version, CORPUS_VERSION);
+    ASSERT_EQ(corpus.header().firstSeed, options.firstSeed);
+    ASSERT_EQ(corpus.header().maxPieces, 150u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(corpus.begin()) % 64, 0u);
+    ASSERT_EQ(std::memcmp(corpus.begin(), records.data(),
+                          records.size() * sizeof(CorpusRecord)),
+              0);
+  }
+
+  // Another version or a truncated file is refused.
+  std::FILE *file = std::fopen(path.c_str(), "r+b");
+  std::fseek(file, 4, SEEK_SET);
+  std::fputc(CORPUS_VERSION + 1, file);
+  std::fclose(file);
+  ASSERT_THROW(Corpus corpus(path), std::runtime_error);
+  writeCorpus(path, options, records);
+  ASSERT_EQ(truncate(path.c_str(), sizeof(CorpusHeader) + 100), 0);
+  ASSERT_THROW(Corpus corpus(path), std::runtime_error);
+  std::remove(path.c_str());
+  ASSERT_THROW(Corpus corpus(path), std::runtime_error);
+}
+
+TEST(SpectatorTest, deltasAndJoiningMidGame) {
+  GameState state(5, RandomizerMode::Bag);
+  Bot bot;
+  SpectatorEncoder encoder(60);
+  SpectatorDecoder fromStart;
+  SpectatorDecoder joined;
+  FrameSnapshot snapshot;
+  std::string stream;
+  int64_t keyframes = 0;
+  while (!state.gameOver && state.frame < 5000) {
+    Action action = bot.nextAction(state);
+    applyAction(state, action);
+    step(state, Action::None);
+    snapshot.capture(state);
+    size_t before = stream.size();
+    keyframes += encoder.encode(snapshot, stream);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(stream.data());
+    ASSERT_EQ(fromStart.decode(data + before, stream.size() - before),
+              stream.size() - before);
+    expectSameFrame(fromStart.snapshot(), state);
+    // The second viewer joins after 500 frames and catches up with the
+    // next keyframe.
+    if (state.frame >= 500) {
+      bool wasSynced = joined.synced();
+      joined.decode(data + before, stream.size() - before);
+      if (!wasSynced && joined.synced()) {
+        ASSERT_LT(state.frame, 500 + 60);
+      }
+      if (joined.synced()) {
+        expectSameFrame(joined.snapshot(), state);
+      }
+    }
+  }
+  ASSERT_TRUE(joined.synced());
+  ASSERT_EQ(fromStart.keyframes(), keyframes);
+  ASSERT_GE(keyframes, state.frame / 60);
+  // Most frames only move the piece: far less than a keyframe per frame.
+  ASSERT_LT(static_cast<double>(stream.size()) / state.frame, 25.0);
+}
+
+TEST(SpectatorTest, serverFeedsViewers) {
+  SpectatorServerOptions options;
+  options.socketPath = "TetrisTest.spectate.sock";
+  auto server = std::make_unique<SpectatorServer>(options);
+  int viewers[2];
+  for (int &fd : viewers) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, options.socketPath.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&address),
+                      sizeof(address)),
+              0);
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (server->viewers() < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(server->viewers(), 2);
+
+  // The viewers read while the game runs, like real ones.
+  std::string received[2];
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([fd = viewers[i], &out = received[i]]() {
+      char buffer[4096];
+      for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;) {
+        out.append(buffer, n);
+      }
+    });
+  }
+
+  GameState state(9);
+  Bot bot;
+  FrameSnapshot snapshot;
+  while (!state.gameOver && state.frame < 2000) {
+    applyAction(state, bot.nextAction(state));
+    step(state, Action::None);
+    snapshot.capture(state);
+    // `publish` drops frames while the server is busy, the last one must
+    // arrive for the comparison below.
+    bool last = state.gameOver || state.frame == 2000;
+    int64_t dropped = server->framesDropped();
+    server->publish(snapshot);
+    while (last && server->framesDropped() > dropped) {
+      std::this_thread::yield();
+      dropped = server->framesDropped();
+      server->publish(snapshot);
+    }
+  }
+  // Sends what is left and closes the connections.
+  server.reset();
+
+  for (int i = 0; i < 2; i++) {
+    readers[i].join();
+    close(viewers[i]);
+    SpectatorDecoder decoder;
+    const std::string &data = received[i];
+    ASSERT_EQ(decoder.decode(reinterpret_cast<const uint8_t *>(data.data()),
+                             data.size()),
+              data.size());
+    ASSERT_TRUE(decoder.synced());
+    expectSameFrame(decoder.snapshot(), state);
+  }
+}
+
+TEST(FrameStatsTest, histogramPercentiles) {
+  DurationHistogram histogram;
+  ASSERT_EQ(histogram.percentile(0.5), 0);
+  for (int i = 1; i <= 1000; i++) {
+    histogram.record(i * 1000);
+  }
+  ASSERT_EQ(histogram.count(), 1000);
+  ASSERT_EQ(histogram.max(), 1000000);
+  // Buckets are about 12% wide, the reported value is the upper bound.
+  ASSERT_GE(histogram.percentile(0.5), 500000);
+  ASSERT_LE(histogram.percentile(0.5), 500000 * 9 / 8);
+  ASSERT_GE(histogram.percentile(0.99), 990000);
+  ASSERT_LE(histogram.percentile(0.99), 1000000);
+  ASSERT_EQ(histogram.percentile(1.0), 1000000);
+  histogram.record(3);
+  ASSERT_EQ(histogram.percentile(0.0), 3);
+}
+
+TEST(InputRepeaterTest, dasAndArr) {
+  RepeatSettings settings;
+  settings.das = 10;
+  settings.arr = 2;
+  settings.releaseFrames = 6;
+  InputRepeater repeater(settings);
+  std::vector<Action> actions;
+
+  // A tap moves once, taps of other keys in the same frame are kept in order.
+  repeater.keyEvent(Action::Left, 0, actions);
+  repeater.keyEvent(Action::RotateClockwise, 0, actions);
+  repeater.keyEvent(Action::Right, 0, actions);
+  ASSERT_EQ(actions, std::vector<Action>({Action::Left,
+                                          Action::RotateClockwise,
+                                          Action::Right}));
+  actions.clear();
+  for (int64_t frame = 0; frame < 30; frame++) {
+    repeater.tick(frame, actions);
+  }
+  ASSERT_TRUE(actions.empty());
+
+  // Held from frame 100: the terminal repeats after its own delay (frame 130)
+  // every 2 frames. Its repeats are swallowed, auto shift starts once they
+  // come (DAS has passed by then) and moves every ARR frames until they stop.
+  repeater.keyEvent(Action::Right, 100, actions);
+  ASSERT_EQ(actions.size(), 1u);
+  int moves = 0;
+  int64_t lastMove = -1;
+  for (int64_t frame = 101; frame < 200; frame++) {
+    if (frame >= 130 && frame <= 160 && frame % 2 == 0) {
+      repeater.keyEvent(Action::Right, frame, actions);
+    }
+    actions.clear();
+    repeater.tick(frame, actions);
+    if (!actions.empty()) {
+      ASSERT_EQ(actions, std::vector<Action>({Action::Right}));
+      ASSERT_TRUE(lastMove == -1 || frame - lastMove == 2);
+      lastMove = frame;
+      moves++;
+    }
+  }
+  ASSERT_EQ(lastMove, 166);
+  ASSERT_EQ(moves, 18);
+}
+
+TEST(VersusTest, garbageAndPlaces) {
+  VersusMatch match(42, 3);
+  // Player 0 clears a tetris with a vertical I in column 0.
+  GameState &attacker = match.player(0).state;
+  for (int row = 16; row < Board::kHeight; row++) {
+    for (int col = 1; col < Board::kWidth; col++) {
+      attacker.field.setCell(row, col, 1);
+    }
+  }
+  attacker.currentTetromino = Tetromino(PIECE_I, 1, 0, 0);
+  match.queueInput(0, Action::HardDrop);
+  match.tick();
+  ASSERT_EQ(attacker.totalLinesCleared, 4);
+  ASSERT_EQ(match.player(0).linesSent, 4);
+  ASSERT_EQ(match.player(1).pendingGarbage.size(), 4u);
+  ASSERT_EQ(match.player(2).pendingGarbage.size(), 0u);
+
+  // The garbage arrives when player 1 locks a piece without clearing.
+  GameState &victim = match.player(1).state;
+  match.queueInput(1, Action::HardDrop);
+  match.tick();
+  ASSERT_TRUE(match.player(1).pendingGarbage.empty());
+  int hole = -1;
+  for (int col = 0; col < Board::kWidth; col++) {
+    if (!victim.field.isOccupied(Board::kHeight - 1, col)) {
+      hole = col;
+    }
+  }
+  ASSERT_GE(hole, 0);
+  for (int row = Board::kHeight - 4; row < Board::kHeight; row++) {
+    ASSERT_EQ(victim.field.getRow(row), Board::kFullRow & ~(1 << hole));
+  }
+  ASSERT_GE(victim.field.columnHeight((hole + 1) % Board::kWidth), 4);
+
+  match.forfeit(2);
+  ASSERT_EQ(match.player(2).place, 3);
+  ASSERT_FALSE(match.isFinished());
+  match.forfeit(0);
+  ASSERT_TRUE(match.isFinished());
+  ASSERT_EQ(match.player(0).place, 2);
+  ASSERT_EQ(match.player(1).place, 1);
+}
+
+// Reads from `fd` until `text` was received or the server closed the socket.
+static std::string readUntil(int fd, const std::string &text) {
+  std::string received;
+  char buffer[1024];
+  while (received.find(text) == std::string::npos) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n <= 0) {
+      break;
+    }
+    received.append(buffer, n);
+  }
+  return received;
+}
+
+TEST(VersusServerTest, matchOverSocket) {
+  VersusServerOptions options;
+  options.socketPath = "TetrisTest.versus.sock";
+  options.playersPerMatch = 2;
+  options.firstSeed = 7;
+  VersusServer server(options);
+  std::thread serverThread([&server]() { server.run(); });
+
+  int fds[2];
+  for (int &fd : fds) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, options.socketPath.c_str());
+    ASSERT_EQ(
+        connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)),
+        0);
+  }
+  ASSERT_NE(readUntil(fds[0], "\n").find("START 7 2 0"), std::string::npos);
+  ASSERT_NE(readUntil(fds[1], "\n").find("START 7 2 1"), std::string::npos);
+  // A hard drop shows up as a new field, then player 0 leaves and player 1
+  // wins.
+  ASSERT_EQ(write(fds[1], "H", 1), 1);
+  std::string lines;
+  int pieces = 0;
+  while (pieces == 0) {
+    lines += readUntil(fds[1], "\n");
+    size_t field = lines.rfind("FIELD");
+    long long frame;
+    ASSERT_NE(field, std::string::npos);
+    ASSERT_EQ(std::sscanf(lines.c_str() + field, "FIELD %lld %d", &frame,
+                          &pieces),
+              2);
+  }
+  ASSERT_EQ(pieces, 1);
+  close(fds[0]);
+  std::string rest = readUntil(fds[1], "OVER");
+  ASSERT_NE(rest.find("OVER 1"), std::string::npos);
+  close(fds[1]);
+
+  server.stop();
+  serverThread.join();
+  ASSERT_EQ(server.stats().matchesFinished, 1);
+}
+
+TEST(ZobristTest, hashFollowsOccupancy) {
+  // The same cells in a different order and color give the same hash.
+  Board a;
+  Board b;
+  a.setCell(19, 0, 1);
+  a.setCell(19, 5, 2);
+  b.setCell(19, 5, 3);
+  b.setCell(19, 0, 4);
+  ASSERT_EQ(a.hash(), b.hash());
+  ASSERT_NE(a.hash(), Board().hash());
+  b.setCell(19, 5, 0);
+  ASSERT_NE(a.hash(), b.hash());
+
+  // Placing and clearing keep the hash equal to a board built cell by cell.
+  Board cleared;
+  fillRow(cleared, 19, {3});
+  fillRow(cleared, 18, {});
+  cleared.setCell(17, 7, 1);
+  const Board::Row dot[] = {0b1};
+  cleared.place(dot, 1, 19, 3, 2);
+  ASSERT_EQ(cleared.clearFullLines(), 2);
+  Board expected;
+  expected.setCell(19, 7, 1);
+  ASSERT_EQ(cleared.hash(), expected.hash());
+}
+
+TEST(ZobristTest, transpositionTable) {
+  TranspositionTable table(4);
+  float value = 0;
+  ASSERT_FALSE(table.probe(0, value));
+  ASSERT_FALSE(table.probe(12345, value));
+  table.store(12345, -1.5f);
+  ASSERT_TRUE(table.probe(12345, value));
+  ASSERT_EQ(value, -1.5f);
+  // Same slot, different key: the newer entry wins.
+  table.store(12345 + 16, 2.0f);
+  ASSERT_FALSE(table.probe(12345, value));
+  ASSERT_TRUE(table.probe(12345 + 16, value));
+  ASSERT_EQ(value, 2.0f);
+}
+
+TEST(ZobristTest, lookaheadWithTable) {
+  // With and without the table the bot makes the same choices, the table
+  // only saves work.
+  TranspositionTable table(18);
+  Bot cached(BotWeights(), 2, &table);
+  Bot uncached(BotWeights(), 2);
+  GameState a(5, RandomizerMode::Bag);
+  GameState b(5, RandomizerMode::Bag);
+  for (int i = 0; i < 30 && !a.gameOver; i++) {
+    ASSERT_TRUE(cached.playPiece(a));
+    ASSERT_TRUE(uncached.playPiece(b));
+    ASSERT_EQ(a.field.getRows(), b.field.getRows());
+  }
+  ASSERT_GT(cached.tableHits(), 0);
+  ASSERT_LT(cached.placementsEvaluated(), uncached.placementsEvaluated());
+}
+
+// ____________________________________________________________________________
+TEST(BatchEvaluatorTest, handCheckedFeatures) {
+  // Column 0 empty (a well of depth 3 next to the wall), a hole in column 5,
+  // one full line at the bottom.
+  Board board;
+  fillRow(board, 16, {0, 1, 2, 3, 4, 6, 7, 8});
+  fillRow(board, 17, {0});
+  fillRow(board, 18, {0, 5});
+  fillRow(board, 19, {});
+  BoardBatch batch;
+  batch.add(board.getRows().data());
+  for (SimdLevel level :
+       {SimdLevel::Scalar, SimdLevel::Sse2, detectSimdLevel()}) {
+    BatchFeatures features;
+    evaluateBatch(batch, features, level);
+    SCOPED_TRACE(simdLevelName(level));
+    ASSERT_EQ(features.linesCleared[0], 1);
+    // Heights after the clear: 0 2 2 2 2 3 2 2 2 3.
+    ASSERT_EQ(features.aggregateHeight[0], 20);
+    ASSERT_EQ(features.holes[0], 1);
+    ASSERT_EQ(features.bumpiness[0], 2 + 1 + 1 + 1);
+    // Rows from the top after the clear: 17 empty rows that do not count,
+    // ".....X...X", ".XXXXXXXXX", ".XXXX.XXXX".
+    ASSERT_EQ(features.rowTransitions[0], 4 + 2 + 4);
+    // Column 0 changes at the floor, column 5 at the top, above and below the
+    // hole, every other column once at the top.
+    ASSERT_EQ(features.columnTransitions[0], 1 + 3 + 8);
+    // Column 0 is a well of depth 2 (1 + 2), the hole in column 5 a well of
+    // depth 1.
+    ASSERT_EQ(features.wellCells[0], 1 + 2 + 1);
+  }
+}
+
+// ____________________________________________________________________________
+TEST(BatchEvaluatorTest, matchesScalarFeatures) {
+  // All variants agree with each other and with `computeFeatures` on the
+  // placements of a real game.
+  Bot bot;
+  PlacementGenerator generator;
+  GameState state(3, RandomizerMode::Bag);
+  for (int i = 0; i < 40 && !state.gameOver; i++) {
+    BoardBatch batch;
+    std::vector<BoardFeatures> scalar;
+    for (const Tetromino &placement :
+         generator.generate(state.field, state.currentTetromino)) {
+      batch.add(state.field, placement);
+      Board placed = state.field;
+      const PieceRotation &shape = placement.getShape();
+      auto [row, col] = placement.getPosition();
+      placed.place(shape.rows, shape.height, row, col, 1);
+      scalar.push_back(computeFeatures(placed.getRows().data()));
+    }
+    BatchFeatures reference;
+    evaluateBatch(batch, reference, SimdLevel::Scalar);
+    for (SimdLevel level : {SimdLevel::Sse2, detectSimdLevel()}) {
+      BatchFeatures features;
+      evaluateBatch(batch, features, level);
+      for (int j = 0; j < batch.size(); j++) {
+        ASSERT_EQ(features.aggregateHeight[j], reference.aggregateHeight[j]);
+        ASSERT_EQ(features.holes[j], reference.holes[j]);
+        ASSERT_EQ(features.bumpiness[j], reference.bumpiness[j]);
+        ASSERT_EQ(features.rowTransitions[j], reference.rowTransitions[j]);
+        ASSERT_EQ(features.columnTransitions[j],
+                  reference.columnTransitions[j]);
+        ASSERT_EQ(features.wellCells[j], reference.wellCells[j]);
+        ASSERT_EQ(features.linesCleared[j], reference.linesCleared[j]);
+      }
+    }
+    for (int j = 0; j < batch.size(); j++) {
+      ASSERT_EQ(reference.aggregateHeight[j], scalar[j].aggregateHeight);
+      ASSERT_EQ(reference.holes[j], scalar[j].holes);
+      ASSERT_EQ(reference.bumpiness[j], scalar[j].bumpiness);
+      ASSERT_EQ(reference.linesCleared[j], scalar[j].linesCleared);
+    }
+    ASSERT_TRUE(bot.playPiece(state));
+  }
+}
+
+// ____________________________________________________________________________
+TEST(BatchEvaluatorTest, matchesBoardFeaturesOnCorpus) {
+  // Every feature that `BatchFeatures` shares with `Board::Features` has the
+  // same value as `featuresAfter`, for every landed placement of the current
+  // piece in corpus positions.
+  CorpusOptions options;
+  options.numPositions = 200;
+  options.maxPieces = 150;
+  options.interval = 5;
+  options.numThreads = 1;
+  PlacementGenerator generator;
+  int checked = 0;
+  for (const CorpusRecord &record : generateCorpus(options)) {
+    Board field;
+    record.loadField(field);
+    BoardBatch batch;
+    std::vector<Board::Features> expected;
+    std::vector<int> lines;
+    for (const Tetromino &placement :
+         generator.generate(field, record.tetromino())) {
+      batch.add(field, placement);
+      const PieceRotation &shape = placement.getShape();
+      auto [row, col] = placement.getPosition();
+      lines.push_back(0);
+      expected.push_back(field.featuresAfter(shape.rows, shape.height,
+                                             shape.width, row, col,
+                                             &lines.back()));
+    }
+    for (SimdLevel level :
+         {SimdLevel::Scalar, SimdLevel::Sse2, detectSimdLevel()}) {
+      SCOPED_TRACE(simdLevelName(level));
+      BatchFeatures features;
+      evaluateBatch(batch, features, level);
+      for (int j = 0; j < batch.size(); j++) {
+        ASSERT_EQ(features.aggregateHeight[j], expected[j].aggregateHeight);
+        ASSERT_EQ(features.holes[j], expected[j].holes);
+        ASSERT_EQ(features.bumpiness[j], expected[j].bumpiness);
+        ASSERT_EQ(features.rowTransitions[j], expected[j].rowTransitions);
+        ASSERT_EQ(features.linesCleared[j], lines[j]);
+      }
+    }
+    checked += batch.size();
+  }
+  ASSERT_GT(checked, 200 * 10);
+}
+
+// ____________________________________________________________________________
+TEST(AnsiScreenTest, onlyChangesAreSent) {
+  AnsiScreen screen({{Color(1, 0, 0), Color(0, 0, 1)}}, 4, 10);
+  // Red on blue in the 256 color palette. A pixel only needs the
+  // background.
+  const std::string pixel = "\033[48;5;196m";
+  const std::string text = "\033[38;5;196;48;5;21m";
+  ASSERT_EQ(screen.compose(), "");
+
+  // Two pixels next to each other: one cursor move, one color.
+  screen.drawPixel(1, 2, 0);
+  screen.drawPixel(1, 3, 0);
+  ASSERT_EQ(screen.compose(), "\033[2;5H" + pixel + "    ");
+  // Nothing changed, nothing to send, also when drawing the same again.
+  ASSERT_EQ(screen.compose(), "");
+  screen.drawPixel(1, 2, 0);
+  ASSERT_EQ(screen.compose(), "");
+
+  // Only the changed characters of a string, each run after its own move.
+  // The color stays set from one frame to the next.
+  screen.drawString(0, 0, 0, "ab");
+  ASSERT_EQ(screen.compose(), "\033[1;1H" + text + "ab");
+  screen.drawString(0, 0, 0, "xbc");
+  ASSERT_EQ(screen.compose(), "\033[1;1Hx\033[1;3Hc");
+
+  // A pixel over text only changes the background, the foreground stays for
+  // the next text. Characters off screen are cut off.
+  screen.drawPixel(0, 0, 0);
+  ASSERT_EQ(screen.compose(), "\033[1;1H" + pixel + "  ");
+  screen.drawString(3, 4, 0, "0123");
+  ASSERT_EQ(screen.compose(), "\033[4;9H\033[48;5;21m01");
+  ASSERT_THROW(screen.drawPixel(0, 0, 1), std::runtime_error);
+
+  screen.invalidate();
+  ASSERT_EQ(screen.compose().find("\033[1;1H" + pixel + "  " + text + "c"),
+            0u);
+  ASSERT_EQ(AnsiScreen::paletteIndex(Color(0.4, 0.4, 0.4)), 241);
+}
+
+// ____________________________________________________________________________
+TEST(SpscQueueTest, orderAndSkipping) {
+  SpscQueue<int, 4> queue;
+  int value;
+  ASSERT_FALSE(queue.tryPop(value));
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.tryPush(i));
+  }
+  ASSERT_FALSE(queue.tryPush(4));
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 0);
+  ASSERT_EQ(queue.skipToLatest(), 2u);
+  ASSERT_TRUE(queue.tryPop(value));
+  ASSERT_EQ(value, 3);
+  ASSERT_EQ(queue.skipToLatest(), 0u);
+  ASSERT_FALSE(queue.tryPop(value));
+
+  // One producer and one consumer thread: every value arrives, in order.
+  // Both yield when they cannot proceed, so this also works on one core.
+  const int count = 100000;
+  std::thread producer([&queue] {
+    for (int i = 0; i < count;) {
+      if (queue.tryPush(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int expected = 0;
+  bool inOrder = true;
+  while (expected < count) {
+    if (queue.tryPop(value)) {
+      inOrder &= value == expected;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  ASSERT_TRUE(inOrder);
+}
@@ -1,30 +1,124 @@
 #pragma once
 
+#include "Board.h"
+#include "Random.h"
 #include "TerminalManager.h"
-#include "Tetris.h"
-#include "Tetromino.h"
-#include <array>
-#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
+#include <initializer_list>
 #include <vector>
 
+// Die sieben Tetrominos. Die Reihenfolge ist die der Tabelle PIECES.
+enum PieceId : uint8_t {
+  PIECE_I,
+  PIECE_T,
+  PIECE_L,
+  PIECE_J,
+  PIECE_O,
+  PIECE_S,
+  PIECE_Z,
+  NUM_PIECES
+};
+
+// Eine Rotation eines Tetrominos: Bounding Box und eine Zeilenmaske pro Zeile
+// (Bit `j` gehört zur Spalte `j` der Bounding Box), dazu pro Spalte die
+// unterste belegte Zeile (für `Board::landingRow`).
+struct PieceRotation {
+  uint8_t height;
+  uint8_t width;
+  PieceMask rows[4];
+  uint8_t bottoms[4];
+};
+
+// Alle Rotationen eines Tetrominos, seine Farbe und seine Startspalte.
+struct PieceType {
+  uint8_t numRotations;
+  uint8_t color;
+  uint8_t spawnCol;
+  PieceRotation rotations[4];
+};
+
+// Baut eine Rotation zur Compile-Zeit aus Zeilen wie "##." auf.
+constexpr PieceRotation makeRotation(const char *r0, const char *r1 = "",
+                                     const char *r2 = "", const char *r3 = "") {
+  const char *lines[4] = {r0, r1, r2, r3};
+  PieceRotation rotation{0, 0, {0, 0, 0, 0}, {0, 0, 0, 0}};
+  for (int i = 0; i < 4 && lines[i][0] != '\0'; i++) {
+    int j = 0;
+    for (; lines[i][j] != '\0'; j++) {
+      if (lines[i][j] == '#') {
+        rotation.rows[i] |= PieceMask{1} << j;
+        rotation.bottoms[j] = i;
+      }
+    }
+    rotation.height = i + 1;
+    rotation.width = j > rotation.width ? j : rotation.width;
+  }
+  return rotation;
+}
+
+// Baut einen Tetromino-Typ auf, die Startspalte ist mittig für Rotation 0.
+constexpr PieceType makePiece(uint8_t color,
+                              std::initializer_list<PieceRotation> rotations) {
+  PieceType piece{0, color, 0, {}};
+  for (const PieceRotation &rotation : rotations) {
+    piece.rotations[piece.numRotations++] = rotation;
+  }
+  piece.spawnCol = Board::kWidth / 2 - piece.rotations[0].width / 2;
+  return piece;
+}
+
+inline constexpr PieceType PIECES[NUM_PIECES] = {
+    makePiece(2, {makeRotation("####"), makeRotation("#", "#", "#", "#")}),
+    makePiece(3, {makeRotation("###", ".#."), makeRotation(".#", "##", ".#"),
+                  makeRotation(".#.", "###"), makeRotation("#.", "##", "#.")}),
+    makePiece(4, {makeRotation("###", "#.."), makeRotation("##", ".#", ".#"),
+                  makeRotation("..#", "###"), makeRotation("#.", "#.", "##")}),
+    makePiece(5, {makeRotation("###", "..#"), makeRotation(".#", ".#", "##"),
+                  makeRotation("#..", "###"), makeRotation("##", "#.", "#.")}),
+    makePiece(6, {makeRotation("##", "##")}),
+    makePiece(7, {makeRotation(".##", "##."), makeRotation("#.", "##", ".#")}),
+    makePiece(8, {makeRotation("##.", ".##"), makeRotation(".#", "##", "#.")}),
+};
+
+// Ein fallender Stein: nur Typ, Rotation und Position. Die Formen selbst
+// stehen in der Tabelle PIECES, kopiert wird hier also nichts Großes.
 class Tetromino {
 public:
-  Tetromino(std::vector<std::vector<std::vector<int>>> shapes, int color);
+  // Erzeugt den Stein in Rotation 0 an seiner Startposition.
+  explicit Tetromino(int piece);
 
-  void rotateClockwise(const std::vector<std::vector<int>> &field);
+  // Erzeugt den Stein in der gegebenen Rotation und Position.
+  Tetromino(int piece, int rotation, int row, int col);
 
-  void rotateCounterClockwise(const std::vector<std::vector<int>> &field);
+  // Die Methoden mit einem Feld gibt es für alle Größen aus Board.h (siehe
+  // Tetromino.cpp).
+  template <class B> void rotateClockwise(const B &field);
+
+  template <class B> void rotateCounterClockwise(const B &field);
 
   // funktion die die shape des Tetrominos zurückgibt
-  const std::vector<std::vector<int>> &getShape() const;
+  const PieceRotation &getShape() const {
+    return PIECES[piece].rotations[state];
+  }
+
+  // Typ und Rotation des Tetrominos.
+  int getPiece() const { return piece; }
+  int getRotation() const { return state; }
 
   // Methode die die Farbe des Tetrominos zurückgibt
-  int getColor() const;
+  int getColor() const { return PIECES[piece].color; }
 
   // Methode die das Tetromino auf dem Sielfeld bewegt
-  bool move(int dx, int dy, const std::vector<std::vector<int>> &field);
+  template <class B> bool move(int dx, int dy, const B &field);
+
+  // Die Zeile, in der der Stein landet, wenn er gerade nach unten fällt.
+  template <class B> int landingRow(const B &field) const;
+
+  // Lässt den Stein sofort bis ganz nach unten fallen. Gibt die Anzahl der
+  // Zeilen zurück, um die er gefallen ist.
+  template <class B> int hardDrop(const B &field);
 
   // Methode zum setzen der Position des Tetrominos
   void setPosition(int r, int c);
@@ -34,48 +128,68 @@ public:
                          int height) const;
 
   // Methode die die aktuelle Position des Tetroinos zurückgibt
-  std::pair<int, int> getPosition() const;
+  std::pair<int, int> getPosition() const { return {row, col}; }
 
 private:
-  bool isValidPosition(int r, int c, int s,
-                       const std::vector<std::vector<int>> &field) const;
-  std::vector<std::vector<std::vector<int>>> shapes;
-  int color;
-  int state;
-  int row;
-  int col;
-  // int currentShapeIndex_;
+  template <class B>
+  bool isValidPosition(int r, int c, int s, const B &field) const;
+  uint8_t piece;
+  uint8_t state;
+  int8_t row;
+  int8_t col;
 };
 
+// Wie die Steine ausgelost werden: `Bag` mischt alle sieben Steine und gibt
+// sie der Reihe nach aus, `Classic` lost jeden Stein einzeln aus und würfelt
+// eine Wiederholung mit Wahrscheinlichkeit 1/7 neu.
+enum class RandomizerMode : uint8_t { Classic, Bag };
+
 // Klasse, die alle Tetrominos und deren eigenschaften enthält
 
 class Tetrominos {
 public:
+  // Höchstens so viele Steine kann die Vorschau zeigen.
+  static constexpr int kMaxPreview = 14;
+
+  // Mit zufälligem Seed (aus der Uhrzeit).
   Tetrominos();
 
+  // Mit festem Seed: gleiche Seeds (und Modi) ergeben bitgenau gleiche Folgen
+  // von Steinen. Jede Instanz hat ihren eigenen Zustand, mehrere Spiele
+  // können also gleichzeitig in verschiedenen Threads laufen. `previewSize`
+  // Steine sind jeweils im Voraus bekannt.
+  explicit Tetrominos(uint64_t seed,
+                      RandomizerMode mode = RandomizerMode::Classic,
+                      int previewSize = 1);
+
   // Methode die einen zufälligen Tetromino zurückgibt
   Tetromino getRandomTetromino();
 
+  // Die Steine, die als nächstes kommen: `peek(0)` ist der, den der nächste
+  // Aufruf von `getRandomTetromino` liefert, usw. bis `previewSize() - 1`.
+  int peek(int i) const { return preview[(previewHead + i) % kMaxPreview]; }
+  int previewSize() const { return numPreview; }
+
+  RandomizerMode getMode() const { return mode; }
+
 private:
-  std::vector<std::vector<std::vector<std::vector<int>>>> tetrominoShapes;
-  std::vector<int> tetrominoColors;
+  // Lost den nächsten Stein für das Ende der Vorschau aus.
+  int generate();
+
+  Random random;
+  RandomizerMode mode;
   int lastIndex;
+  uint8_t bag[NUM_PIECES];
+  int bagPosition;
+  uint8_t preview[kMaxPreview];
+  int previewHead;
+  int numPreview;
   // void initializeTetrominos();
 };
 
-void updateTetromino(Tetromino &currentTetromino, Tetrominos &tetrominos,
-                     std::vector<std::vector<int>> &field,
-                     std::chrono::steady_clock::time_point &lastTick,
-                     bool &running, const int FIELD_WIDTH, int &TICK_RATE_MS,
-                     int &totalLinesCleared, int &linesClearedAtOnce,
-                     Tetromino &nextTetromino, TerminalManager &terminal,
-                     int &level);
-
-void placeTetrominoInField(std::vector<std::vector<int>> &field,
-                           const Tetromino &tetromino);
-
-void checkAndRemoveFullLines(std::vector<std::vector<int>> &field,
-                             int &totalLinesCleared, int &linesClearedAtOnce);
+// Setzt den Stein in seiner Farbe ins Feld (siehe `Board::place`).
+template <class B>
+void placeTetrominoInField(B &field, const Tetromino &tetromino,
+                           typename B::Undo *undo = nullptr);
 
 // void drawNextTetromino(TerminalManager &terminal, int row, int col);
-int calculateTickRate(int level);
@@ -0,0 +1,351 @@
+#include "TrainingExport.h"
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <zlib.h>
+
+static const char TRAINING_MAGIC[4] = {'T', 'T', 'R', 'D'};
+static const size_t TRAINING_HEADER_SIZE = 16;
+static const size_t TRAINING_BLOCK_HEADER_SIZE = 16;
+static const int TRAINING_COLUMNS = 8;
+// Bytes pro Datensatz in jeder Spalte.
+static const int COLUMN_WIDTHS[TRAINING_COLUMNS] = {
+    TrainingSample::kBoardBytes, 1, 1, 1, 1, 1, 1, 1};
+
+namespace {
+void putU32(uint8_t *p, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = value >> (8 * i);
+  }
+}
+
+uint32_t getU32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+} // namespace
+
+void TrainingSample::packBoard(const Board &field) {
+  board.fill(0);
+  for (int row = 0; row < Board::kHeight; row++) {
+    // Eine Zeile passt immer in 16 Bit, liegt aber nicht auf Bytegrenzen.
+    uint32_t bits = static_cast<uint32_t>(field.getRow(row))
+                    << ((row * Board::kWidth) % 8);
+    for (int byte = row * Board::kWidth / 8; bits != 0; byte++) {
+      board[byte] |= bits & 0xff;
+      bits >>= 8;
+    }
+  }
+}
+
+std::array<Board::Row, Board::kHeight> TrainingSample::unpackBoard() const {
+  std::array<Board::Row, Board::kHeight> rows;
+  for (int row = 0; row < Board::kHeight; row++) {
+    int first = row * Board::kWidth;
+    uint32_t bits = 0;
+    for (int byte = first / 8, shift = 0;
+         byte <= (first + Board::kWidth - 1) / 8; byte++, shift += 8) {
+      bits |= static_cast<uint32_t>(board[byte]) << shift;
+    }
+    rows[row] = (bits >> (first % 8)) & Board::kFullRow;
+  }
+  return rows;
+}
+
+bool TrainingSample::operator==(const TrainingSample &other) const {
+  return board == other.board && piece == other.piece &&
+         nextPiece == other.nextPiece && rotation == other.rotation &&
+         row == other.row && col == other.col &&
+         linesCleared == other.linesCleared && gameOver == other.gameOver;
+}
+
+TrainingWriter::TrainingWriter(const std::string &path,
+                               const TrainingWriterOptions &options)
+    : options_(options), file_(std::fopen(path.c_str(), "wb")),
+      closing_(false), samplesWritten_(0), bytesWritten_(0), stalls_(0) {
+  if (file_ == nullptr) {
+    throw std::runtime_error("Could not open training file " + path);
+  }
+  if (options_.blockSamples <= 0 || options_.maxPendingBlocks <= 0) {
+    std::fclose(file_);
+    throw std::runtime_error("Invalid options for training file " + path);
+  }
+  uint8_t header[TRAINING_HEADER_SIZE] = {};
+  std::memcpy(header, TRAINING_MAGIC, 4);
+  header[4] = TRAINING_VERSION;
+  header[5] = Board::kWidth;
+  header[6] = Board::kHeight;
+  header[7] = TRAINING_COLUMNS;
+  if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+    std::fclose(file_);
+    throw std::runtime_error("Could not write training file " + path);
+  }
+  bytesWritten_ = sizeof(header);
+  current_ = newBlock();
+  thread_ = std::thread(&TrainingWriter::run, this);
+}
+
+TrainingWriter::~TrainingWriter() {
+  try {
+    finish();
+  } catch (const std::exception &) {
+    // Wer den Fehler sehen will, ruft `finish` selbst auf.
+  }
+}
+
+std::unique_ptr<TrainingWriter::Block> TrainingWriter::newBlock() {
+  if (!free_.empty()) {
+    std::unique_ptr<Block> block = std::move(free_.back());
+    free_.pop_back();
+    block->size = 0;
+    return block;
+  }
+  auto block = std::make_unique<Block>();
+  for (int c = 0; c < TRAINING_COLUMNS; c++) {
+    block->columns[c].resize(options_.blockSamples * COLUMN_WIDTHS[c]);
+  }
+  return block;
+}
+
+void TrainingWriter::append(const TrainingSample *samples, size_t count) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (closing_) {
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const TrainingSample &sample = samples[i];
+    Block &block = *current_;
+    int n = block.size++;
+    std::memcpy(&block.columns[0][n * TrainingSample::kBoardBytes],
+                sample.board.data(), TrainingSample::kBoardBytes);
+    block.columns[1][n] = sample.piece;
+    block.columns[2][n] = sample.nextPiece;
+    block.columns[3][n] = sample.rotation;
+    block.columns[4][n] = sample.row;
+    block.columns[5][n] = sample.col;
+    block.columns[6][n] = sample.linesCleared;
+    block.columns[7][n] = sample.gameOver;
+    if (block.size == options_.blockSamples) {
+      submit(lock);
+    }
+  }
+}
+
+void TrainingWriter::submit(std::unique_lock<std::mutex> &lock) {
+  if (static_cast<int>(full_.size()) >= options_.maxPendingBlocks) {
+    stalls_++;
+    wakeAppend_.wait(lock, [this] {
+      return static_cast<int>(full_.size()) < options_.maxPendingBlocks;
+    });
+  }
+  full_.push_back(std::move(current_));
+  current_ = newBlock();
+  wakeWriter_.notify_one();
+}
+
+void TrainingWriter::finish() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closing_) {
+      return;
+    }
+    if (current_->size > 0) {
+      submit(lock);
+    }
+    closing_ = true;
+  }
+  wakeWriter_.notify_one();
+  thread_.join();
+  bool closed = std::fclose(file_) == 0;
+  file_ = nullptr;
+  if (error_.empty() && !closed) {
+    error_ = "Could not write training file";
+  }
+  if (!error_.empty()) {
+    throw std::runtime_error(error_);
+  }
+}
+
+void TrainingWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wakeWriter_.wait(lock, [this] { return !full_.empty() || closing_; });
+    if (full_.empty()) {
+      return;
+    }
+    std::unique_ptr<Block> block = std::move(full_.front());
+    full_.pop_front();
+    wakeAppend_.notify_all();
+    // Komprimieren und Schreiben ohne Lock, `append` läuft derweil weiter.
+    lock.unlock();
+    if (error_.empty()) {
+      try {
+        writeBlock(*block);
+      } catch (const std::exception &e) {
+        error_ = e.what();
+      }
+    }
+    lock.lock();
+    samplesWritten_ += error_.empty() ? block->size : 0;
+    free_.push_back(std::move(block));
+  }
+}
+
+void TrainingWriter::writeBlock(const Block &block) {
+  raw_.clear();
+  for (int c = 0; c < TRAINING_COLUMNS; c++) {
+    raw_.insert(raw_.end(), block.columns[c].begin(),
+                block.columns[c].begin() + block.size * COLUMN_WIDTHS[c]);
+  }
+  const uint8_t *stored = raw_.data();
+  uLongf storedSize = raw_.size();
+  uint8_t compression = 0;
+  if (options_.compress) {
+    compressed_.resize(compressBound(raw_.size()));
+    uLongf size = compressed_.size();
+    // Stufe 1: Die Daten sind sehr redundant, mehr Aufwand bringt kaum etwas.
+    if (compress2(compressed_.data(), &size, raw_.data(), raw_.size(), 1) ==
+            Z_OK &&
+        size < raw_.size()) {
+      stored = compressed_.data();
+      storedSize = size;
+      compression = 1;
+    }
+  }
+  uint8_t header[TRAINING_BLOCK_HEADER_SIZE] = {};
+  putU32(header, block.size);
+  putU32(header + 4, raw_.size());
+  putU32(header + 8, storedSize);
+  header[12] = compression;
+  if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header) ||
+      std::fwrite(stored, 1, storedSize, file_) != storedSize) {
+    throw std::runtime_error("Could not write training file");
+  }
+  bytesWritten_ += sizeof(header) + storedSize;
+}
+
+TrainingReader::TrainingReader(const std::string &path)
+    : file_(std::fopen(path.c_str(), "rb")), path_(path) {
+  if (file_ == nullptr) {
+    throw std::runtime_error("Could not open training file " + path);
+  }
+  uint8_t header[TRAINING_HEADER_SIZE];
+  if (std::fread(header, 1, sizeof(header), file_) != sizeof(header) ||
+      std::memcmp(header, TRAINING_MAGIC, 4) != 0 ||
+      header[4] != TRAINING_VERSION || header[5] != Board::kWidth ||
+      header[6] != Board::kHeight || header[7] != TRAINING_COLUMNS) {
+    std::fclose(file_);
+    throw std::runtime_error("Not a training file of version " +
+                             std::to_string(TRAINING_VERSION) + ": " + path);
+  }
+}
+
+TrainingReader::~TrainingReader() { std::fclose(file_); }
+
+bool TrainingReader::nextBlock(std::vector<TrainingSample> &samples) {
+  uint8_t header[TRAINING_BLOCK_HEADER_SIZE];
+  size_t got = std::fread(header, 1, sizeof(header), file_);
+  if (got == 0) {
+    return false;
+  }
+  if (got != sizeof(header) || header[12] > 1) {
+    throw std::runtime_error("Corrupt training file " + path_);
+  }
+  uint32_t count = getU32(header);
+  uint32_t rawSize = getU32(header + 4);
+  uint32_t storedSize = getU32(header + 8);
+  size_t expected = 0;
+  for (int c = 0; c < TRAINING_COLUMNS; c++) {
+    expected += static_cast<size_t>(count) * COLUMN_WIDTHS[c];
+  }
+  // Die Größen erst prüfen, dann Speicher dafür anlegen: Die Daten müssen
+  // noch in der Datei stehen, und zlib komprimiert höchstens etwa 1:1032.
+  struct stat info;
+  long position = std::ftell(file_);
+  if (rawSize != expected || fstat(fileno(file_), &info) != 0 ||
+      position < 0 || storedSize > info.st_size - position ||
+      (header[12] == 0 && storedSize != rawSize) ||
+      (header[12] == 1 && (storedSize > compressBound(rawSize) ||
+                           rawSize / 1032 > storedSize))) {
+    throw std::runtime_error("Corrupt training file " + path_);
+  }
+  stored_.resize(storedSize);
+  if (std::fread(stored_.data(), 1, storedSize, file_) != storedSize) {
+    throw std::runtime_error("Corrupt training file " + path_);
+  }
+  if (header[12] == 1) {
+    raw_.resize(rawSize);
+    uLongf size = rawSize;
+    if (uncompress(raw_.data(), &size, stored_.data(), storedSize) != Z_OK ||
+        size != rawSize) {
+      throw std::runtime_error("Corrupt training file " + path_);
+    }
+  } else {
+    raw_.swap(stored_);
+  }
+
+  samples.resize(count);
+  const uint8_t *column = raw_.data();
+  for (uint32_t i = 0; i < count; i++) {
+    std::memcpy(samples[i].board.data(),
+                column + i * TrainingSample::kBoardBytes,
+                TrainingSample::kBoardBytes);
+  }
+  column += count * TrainingSample::kBoardBytes;
+  for (uint32_t i = 0; i < count; i++) {
+    TrainingSample &sample = samples[i];
+    sample.piece = column[i];
+    sample.nextPiece = column[count + i];
+    sample.rotation = column[2 * count + i];
+    sample.row = column[3 * count + i];
+    sample.col = column[4 * count + i];
+    sample.linesCleared = column[5 * count + i];
+    sample.gameOver = column[6 * count + i];
+  }
+  return true;
+}
+
+// So viele Datensätze sammelt `DecisionLog`, bevor es sie übergibt.
+static const size_t DECISION_LOG_BATCH = 1024;
+
+DecisionLog::DecisionLog(TrainingWriter &writer)
+    : writer_(writer), last_(PIECE_I), piecesPlaced_(0) {
+  samples_.reserve(DECISION_LOG_BATCH);
+}
+
+DecisionLog::~DecisionLog() { flush(); }
+
+void DecisionLog::begin(const GameState &state) {
+  piecesPlaced_ = state.piecesPlaced;
+  field_ = state.field;
+  pending_.packBoard(field_);
+  pending_.piece = state.currentTetromino.getPiece();
+  pending_.nextPiece = state.nextTetromino.getPiece();
+  last_ = state.currentTetromino;
+}
+
+void DecisionLog::observe(const GameState &state) {
+  if (state.piecesPlaced == piecesPlaced_) {
+    last_ = state.currentTetromino;
+    return;
+  }
+  // Der Stein wurde festgesetzt. Pro `applyAction` bzw. `step` passiert das
+  // höchstens einmal, und das Feld hat sich seit dem Erscheinen des Steins
+  // nicht geändert.
+  last_.hardDrop(field_);
+  auto [row, col] = last_.getPosition();
+  pending_.rotation = last_.getRotation();
+  pending_.row = row;
+  pending_.col = col;
+  pending_.linesCleared = state.lastClear.lines;
+  pending_.gameOver = state.gameOver;
+  samples_.push_back(pending_);
+  if (samples_.size() >= DECISION_LOG_BATCH) {
+    flush();
+  }
+  begin(state);
+}
+
+void DecisionLog::flush() {
+  writer_.append(samples_.data(), samples_.size());
+  samples_.clear();
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Game.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Export von Trainingsdaten: ein Datensatz pro Entscheidung, also pro Stein,
+// mit dem Feld vor dem Stein, dem Stein, dem nächsten Stein, der gewählten
+// Endposition und dem Ergebnis.
+//
+// Format (alle Zahlen little-endian):
+//   Header, 16 Bytes: "TTRD", Version (1 Byte), Breite und Höhe des Feldes
+//   (je 1 Byte), Anzahl der Spalten (1 Byte), 0 (8 Bytes).
+//   Danach Blöcke mit je einem Header von 16 Bytes: Anzahl der Datensätze,
+//   Größe der Daten unkomprimiert und in der Datei (je 4 Bytes),
+//   Kompression (1 Byte, 0 = keine, 1 = zlib), 0 (3 Bytes).
+//   Die Daten eines Blocks sind spaltenweise: erst die Felder aller
+//   Datensätze, dann alle Steine usw. (Reihenfolge wie in `TrainingSample`).
+//   Ein Feld ist als Bitfeld gepackt, Bit `row * Breite + col` (von Bit 0
+//   des ersten Bytes an) ist die Zelle (row, col), oberste Zeile zuerst.
+
+const uint8_t TRAINING_VERSION = 1;
+
+// Ein Datensatz.
+struct TrainingSample {
+  static constexpr int kBoardBytes = (Board::kWidth * Board::kHeight + 7) / 8;
+
+  // Das Feld, bevor der Stein gesetzt wurde.
+  std::array<uint8_t, kBoardBytes> board{};
+  // Aktueller und nächster Stein (Index in PIECES).
+  uint8_t piece = 0;
+  uint8_t nextPiece = 0;
+  // Wo der Stein festgesetzt wurde.
+  uint8_t rotation = 0;
+  int8_t row = 0;
+  int8_t col = 0;
+  // Dadurch entfernte Zeilen, und ob das Spiel danach vorbei war.
+  uint8_t linesCleared = 0;
+  uint8_t gameOver = 0;
+
+  void packBoard(const Board &field);
+  std::array<Board::Row, Board::kHeight> unpackBoard() const;
+
+  bool operator==(const TrainingSample &other) const;
+};
+
+struct TrainingWriterOptions {
+  // Datensätze pro Block (ein Block hat etwa 32 Bytes pro Datensatz).
+  int blockSamples = 1 << 16;
+  bool compress = true;
+  // Höchstens so viele volle Blöcke warten auf das Schreiben, danach wartet
+  // `append`.
+  int maxPendingBlocks = 8;
+};
+
+// Schreibt Datensätze in eine Datei. `append` kopiert nur in den aktuellen
+// Block; volle Blöcke komprimiert und schreibt ein eigener Thread, die
+// Simulation wartet also nicht auf zlib oder die Platte. Nur wenn die Platte
+// dauerhaft langsamer ist als die Simulation, wartet `append`, sobald
+// `maxPendingBlocks` Blöcke anstehen (siehe `stalls`).
+class TrainingWriter {
+public:
+  // Öffnet die Datei und schreibt den Header. Wirft bei Fehlern eine
+  // Exception.
+  explicit TrainingWriter(const std::string &path,
+                          const TrainingWriterOptions &options = {});
+  ~TrainingWriter();
+  TrainingWriter(const TrainingWriter &) = delete;
+  TrainingWriter &operator=(const TrainingWriter &) = delete;
+
+  // Hängt Datensätze an, aus beliebigen Threads.
+  void append(const TrainingSample *samples, size_t count);
+
+  // Schreibt den letzten Block, wartet auf den Thread und schließt die
+  // Datei. Wirft eine Exception, wenn beim Schreiben etwas schiefging.
+  void finish();
+
+  int64_t samplesWritten() const { return samplesWritten_; }
+  int64_t bytesWritten() const { return bytesWritten_; }
+  int64_t stalls() const { return stalls_; }
+
+private:
+  // Ein Block, spaltenweise; jede Spalte hat Platz für `blockSamples`.
+  struct Block {
+    int size = 0;
+    std::vector<uint8_t> columns[8];
+  };
+
+  std::unique_ptr<Block> newBlock();
+  // Übergibt `current_` an den Thread (mit gehaltenem Lock).
+  void submit(std::unique_lock<std::mutex> &lock);
+  void run();
+  void writeBlock(const Block &block);
+
+  TrainingWriterOptions options_;
+  std::FILE *file_;
+  std::mutex mutex_;
+  // Signalisiert dem Thread neue Blöcke und `append` freie.
+  std::condition_variable wakeWriter_;
+  std::condition_variable wakeAppend_;
+  std::unique_ptr<Block> current_;
+  std::deque<std::unique_ptr<Block>> full_;
+  // Geschriebene Blöcke zur Wiederverwendung.
+  std::vector<std::unique_ptr<Block>> free_;
+  bool closing_;
+  std::string error_;
+  std::atomic<int64_t> samplesWritten_;
+  std::atomic<int64_t> bytesWritten_;
+  std::atomic<int64_t> stalls_;
+  // Nur vom Thread benutzt.
+  std::vector<uint8_t> raw_;
+  std::vector<uint8_t> compressed_;
+  std::thread thread_;
+};
+
+// Liest eine Datei von `TrainingWriter` blockweise. Wirft bei Fehlern eine
+// Exception.
+class TrainingReader {
+public:
+  explicit TrainingReader(const std::string &path);
+  ~TrainingReader();
+  TrainingReader(const TrainingReader &) = delete;
+  TrainingReader &operator=(const TrainingReader &) = delete;
+
+  // Liest den nächsten Block nach `samples`, false am Ende der Datei.
+  bool nextBlock(std::vector<TrainingSample> &samples);
+
+private:
+  std::FILE *file_;
+  std::string path_;
+  std::vector<uint8_t> stored_;
+  std::vector<uint8_t> raw_;
+};
+
+// Macht aus einem laufenden Spiel Datensätze: `observe` wird nach jeder
+// Änderung des Zustands aufgerufen (jedem `applyAction` und `step`) und
+// erkennt selbst, wann ein Stein festgesetzt wurde. Die Endposition ist die
+// letzte Position des Steins, fallen gelassen auf das Feld vor dem Stein.
+// Die Datensätze gehen gesammelt an den `TrainingWriter`.
+class DecisionLog {
+public:
+  explicit DecisionLog(TrainingWriter &writer);
+  ~DecisionLog();
+  DecisionLog(const DecisionLog &) = delete;
+  DecisionLog &operator=(const DecisionLog &) = delete;
+
+  // Beginnt ein neues Spiel mit `state`.
+  void begin(const GameState &state);
+  void observe(const GameState &state);
+
+  // Gibt die gesammelten Datensätze an den Writer.
+  void flush();
+
+private:
+  TrainingWriter &writer_;
+  std::vector<TrainingSample> samples_;
+  // Der Datensatz für den aktuellen Stein, ohne Endposition und Ergebnis.
+  TrainingSample pending_;
+  Board field_;
+  Tetromino last_;
+  int piecesPlaced_;
+};
@@ -0,0 +1,59 @@
+#include "TranspositionTable.h"
+#include "Random.h"
+#include <cstring>
+
+namespace {
+// Markiert einen Eintrag als belegt, damit ein leerer Eintrag (alles 0) nicht
+// zum Schlüssel 0 passt.
+const uint64_t VALID = uint64_t{1} << 32;
+} // namespace
+
+TranspositionTable::TranspositionTable(int log2Entries)
+    : entries_(new Entry[uint64_t{1} << log2Entries]),
+      mask_((uint64_t{1} << log2Entries) - 1) {
+  clear();
+}
+
+bool TranspositionTable::probe(uint64_t key, float &value) const {
+  const Entry &entry = entries_[key & mask_];
+  uint64_t data = entry.data.load(std::memory_order_relaxed);
+  uint64_t check = entry.check.load(std::memory_order_relaxed);
+  if ((check ^ data) != key || !(data & VALID)) {
+    return false;
+  }
+  uint32_t bits = static_cast<uint32_t>(data);
+  std::memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+void TranspositionTable::store(uint64_t key, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint64_t data = VALID | bits;
+  Entry &entry = entries_[key & mask_];
+  entry.check.store(key ^ data, std::memory_order_relaxed);
+  entry.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+  for (uint64_t i = 0; i <= mask_; i++) {
+    entries_[i].check.store(0, std::memory_order_relaxed);
+    entries_[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t TranspositionTable::pieceKey(int position, int piece) {
+  // Die Zufallswerte werden beim ersten Aufruf erzeugt.
+  static const struct Keys {
+    uint64_t keys[16][8];
+    Keys() {
+      Random random(0x7069656365732121);
+      for (auto &row : keys) {
+        for (uint64_t &key : row) {
+          key = random.next();
+        }
+      }
+    }
+  } KEYS;
+  return KEYS.keys[position & 15][piece & 7];
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Tabelle fester Größe für schon bewertete Stellungen der Vorausschau des
+// Bots. Der Schlüssel ist der Zobrist-Hash des Feldes, kombiniert mit den
+// noch kommenden Steinen (`pieceKey`). Mehrere Threads dürfen gleichzeitig
+// lesen und schreiben, ohne Lock: Jeder Eintrag speichert `Schlüssel XOR
+// Daten` neben den Daten, ein halb geschriebener Eintrag passt dann nicht
+// mehr zum Schlüssel und wird wie ein Fehlschlag behandelt. Bei Kollisionen
+// gewinnt der neueste Eintrag.
+class TranspositionTable {
+public:
+  // Eine Tabelle mit 2^`log2Entries` Einträgen zu je 16 Bytes.
+  explicit TranspositionTable(int log2Entries = 20);
+
+  // Sucht den Wert zu `key`. Gibt false zurück, wenn er nicht gespeichert ist.
+  bool probe(uint64_t key, float &value) const;
+
+  void store(uint64_t key, float value);
+
+  // Leert die Tabelle (nicht gleichzeitig mit `probe` oder `store`).
+  void clear();
+
+  int64_t numEntries() const { return mask_ + 1; }
+
+  // Der Anteil am Schlüssel für Stein `piece` an Position `position` der noch
+  // kommenden Steine.
+  static uint64_t pieceKey(int position, int piece);
+
+private:
+  struct Entry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+  std::unique_ptr<Entry[]> entries_;
+  uint64_t mask_;
+};
@@ -0,0 +1,113 @@
+#include "Versus.h"
+
+VersusMatch::VersusMatch(uint64_t seed, int numPlayers)
+    : random_(seed ^ 0x6761726261676521), alive_(numPlayers), nextTarget_(0) {
+  players_.reserve(numPlayers);
+  for (int i = 0; i < numPlayers; i++) {
+    players_.emplace_back(seed);
+  }
+}
+
+int VersusMatch::garbageFor(int lines) {
+  static const int GARBAGE[5] = {0, 0, 1, 2, 4};
+  return GARBAGE[lines < 0 ? 0 : (lines > 4 ? 4 : lines)];
+}
+
+void VersusMatch::queueInput(int index, Action action) {
+  if (action != Action::None && players_[index].place == 0) {
+    players_[index].inputs.push_back(action);
+  }
+}
+
+void VersusMatch::forfeit(int index) {
+  if (players_[index].place == 0) {
+    players_[index].state.gameOver = true;
+    eliminate(index);
+  }
+}
+
+void VersusMatch::tick() {
+  for (int i = 0; i < numPlayers(); i++) {
+    VersusPlayer &player = players_[i];
+    if (player.place != 0) {
+      continue;
+    }
+    GameState &state = player.state;
+    for (Action action : player.inputs) {
+      int pieces = state.piecesPlaced;
+      int lines = state.totalLinesCleared;
+      applyAction(state, action);
+      settle(i, pieces, lines);
+    }
+    player.inputs.clear();
+    int pieces = state.piecesPlaced;
+    int lines = state.totalLinesCleared;
+    step(state, Action::None);
+    settle(i, pieces, lines);
+  }
+}
+
+void VersusMatch::settle(int index, int piecesBefore, int linesBefore) {
+  VersusPlayer &player = players_[index];
+  GameState &state = player.state;
+  if (player.place != 0) {
+    return;
+  }
+  if (state.piecesPlaced != piecesBefore && !state.gameOver) {
+    int cleared = state.totalLinesCleared - linesBefore;
+    int garbage = garbageFor(cleared);
+    while (garbage > 0 && !player.pendingGarbage.empty()) {
+      player.pendingGarbage.pop_front();
+      garbage--;
+    }
+    if (garbage > 0 && alive_ > 1) {
+      // Reihum an den nächsten lebenden Gegner, mit einem Loch pro Sendung.
+      int target = nextTarget_;
+      do {
+        target = (target + 1) % numPlayers();
+      } while (target == index || players_[target].place != 0);
+      nextTarget_ = target;
+      uint8_t hole = random_.below(Board::kWidth);
+      players_[target].pendingGarbage.insert(
+          players_[target].pendingGarbage.end(), garbage, hole);
+      player.linesSent += garbage;
+    }
+    if (cleared == 0 && !player.pendingGarbage.empty()) {
+      // Der nächste Stein ist schon da. Wird er vom Müll verdeckt oder Müll
+      // oben hinausgeschoben, ist das Spiel vorbei.
+      bool fits = true;
+      while (!player.pendingGarbage.empty()) {
+        uint8_t hole = player.pendingGarbage.front();
+        int count = 0;
+        while (!player.pendingGarbage.empty() &&
+               player.pendingGarbage.front() == hole) {
+          player.pendingGarbage.pop_front();
+          count++;
+        }
+        fits &= state.field.addGarbage(count, hole, GARBAGE_COLOR);
+      }
+      const PieceRotation &shape = state.currentTetromino.getShape();
+      auto [row, col] = state.currentTetromino.getPosition();
+      if (!fits ||
+          !state.field.fits(shape.rows, shape.height, shape.width, row, col)) {
+        state.gameOver = true;
+      }
+    }
+  }
+  if (state.gameOver) {
+    eliminate(index);
+  }
+}
+
+void VersusMatch::eliminate(int index) {
+  players_[index].place = alive_;
+  players_[index].inputs.clear();
+  alive_--;
+  if (alive_ == 1 && players_.size() > 1) {
+    for (VersusPlayer &player : players_) {
+      if (player.place == 0) {
+        player.place = 1;
+      }
+    }
+  }
+}
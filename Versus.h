@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Game.h"
+#include "Random.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Regeln für ein Versus-Spiel mehrerer Spieler, ohne Netzwerk: Jeder Spieler
+// hat sein eigenes Feld, alle bekommen dieselbe Folge von Steinen (gleicher
+// Seed). Wer mit einem Stein Zeilen entfernt, schickt Müllzeilen an einen
+// Gegner (reihum an die noch lebenden). Eigene entfernte Zeilen heben zuerst
+// noch nicht eingefügten Müll auf, der Rest wird eingefügt, sobald der
+// Spieler einen Stein ablegt, ohne eine Zeile zu entfernen.
+
+// Farbe der Müllzeilen.
+const int GARBAGE_COLOR = 1;
+
+struct VersusPlayer {
+  explicit VersusPlayer(uint64_t seed) : state(seed, RandomizerMode::Bag) {}
+
+  GameState state;
+  // Eingaben für den nächsten Frame, in der Reihenfolge ihres Eintreffens.
+  std::vector<Action> inputs;
+  // Noch nicht eingefügte Müllzeilen, pro Zeile die Spalte des Lochs.
+  std::deque<uint8_t> pendingGarbage;
+  int linesSent = 0;
+  // Platz am Ende (1 = Sieger), 0 solange der Spieler noch spielt.
+  int place = 0;
+};
+
+class VersusMatch {
+public:
+  VersusMatch(uint64_t seed, int numPlayers);
+
+  int numPlayers() const { return players_.size(); }
+  VersusPlayer &player(int index) { return players_[index]; }
+  const VersusPlayer &player(int index) const { return players_[index]; }
+
+  // Merkt sich eine Eingabe für den nächsten `tick`.
+  void queueInput(int index, Action action);
+
+  // Der Spieler gibt auf (z.B. weil die Verbindung weg ist).
+  void forfeit(int index);
+
+  // Ein Frame für alle Spieler: erst ihre Eingaben, dann die Schwerkraft.
+  void tick();
+
+  // Vorbei, wenn höchstens noch ein Spieler übrig ist (allein gespielt: wenn
+  // das Spiel vorbei ist).
+  bool isFinished() const { return alive_ <= (players_.size() > 1 ? 1 : 0); }
+
+  // So viele Müllzeilen schickt das gleichzeitige Entfernen von `lines`
+  // Zeilen.
+  static int garbageFor(int lines);
+
+private:
+  // Nach jeder Eingabe und jedem Frame: Müll verschicken bzw. einfügen, wenn
+  // ein Stein abgelegt wurde, und ausgeschiedene Spieler platzieren.
+  void settle(int index, int piecesBefore, int linesBefore);
+  void eliminate(int index);
+
+  std::vector<VersusPlayer> players_;
+  Random random_;
+  int alive_;
+  int nextTarget_;
+};
@@ -0,0 +1,173 @@
+#include "./Game.h"
+#include "./Random.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+// Skriptbare Clients für den Versus-Server: verbindet viele Clients, die
+// zufällige Eingaben schicken, bis alle ihre Spiele vorbei sind. Zum Testen
+// der Last und der Regeln, ohne Terminal.
+
+namespace {
+struct Client {
+  int fd = -1;
+  bool started = false;
+  int place = 0;
+  int lines = 0;
+  int pieces = 0;
+  std::string in;
+};
+
+int connectTo(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) < 0) {
+    std::perror(path.c_str());
+    std::exit(1);
+  }
+  return fd;
+}
+
+// Wertet die vollständigen Zeilen in `client.in` aus.
+void parseLines(Client &client) {
+  size_t start = 0;
+  for (size_t end; (end = client.in.find('\n', start)) != std::string::npos;
+       start = end + 1) {
+    const char *line = client.in.c_str() + start;
+    long long frame;
+    if (std::strncmp(line, "START", 5) == 0) {
+      client.started = true;
+    } else if (std::sscanf(line, "FIELD %lld %d %d", &frame, &client.pieces,
+                           &client.lines) == 3) {
+    } else if (std::sscanf(line, "OVER %d", &client.place) == 1) {
+    }
+  }
+  client.in.erase(0, start);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string socketPath = "/tmp/tetris-versus.sock";
+  int numClients = 2;
+  double actionsPerSecond = 10;
+  double maxSeconds = 60;
+  uint64_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--socket") == 0 && hasValue) {
+      socketPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--clients") == 0 && hasValue) {
+      numClients = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+      actionsPerSecond = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue) {
+      maxSeconds = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--socket PATH] [--clients N] [--rate ACTIONS_PER_SEC]"
+                   " [--seconds S] [--seed S]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Client> clients(numClients);
+  for (int i = 0; i < numClients; i++) {
+    clients[i].fd = connectTo(socketPath);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = i;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].fd, &event);
+  }
+  int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  itimerspec interval{};
+  interval.it_interval.tv_nsec = 1000000000 / FRAMES_PER_SECOND;
+  interval.it_value = interval.it_interval;
+  timerfd_settime(timerFd, 0, &interval, nullptr);
+  epoll_event timerEvent{};
+  timerEvent.events = EPOLLIN;
+  timerEvent.data.u32 = numClients;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &timerEvent);
+
+  // Hard Drops kommen seltener, damit die Steine auch seitlich wandern.
+  const char ACTIONS[] = "LLRRCADDH";
+  Random random(seed);
+  int open = numClients;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<epoll_event> events(numClients + 1);
+  char buffer[4096];
+  while (open > 0 &&
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                 .count() < maxSeconds) {
+    int n = epoll_wait(epollFd, events.data(), events.size(), 100);
+    for (int e = 0; e < n; e++) {
+      uint32_t index = events[e].data.u32;
+      if (index == static_cast<uint32_t>(numClients)) {
+        uint64_t expirations;
+        if (read(timerFd, &expirations, sizeof(expirations)) < 0) {
+          continue;
+        }
+        for (Client &client : clients) {
+          if (client.fd >= 0 && client.started &&
+              random.below(1000000) < actionsPerSecond * 1000000 /
+                                          FRAMES_PER_SECOND) {
+            char action = ACTIONS[random.below(sizeof(ACTIONS) - 1)];
+            if (send(client.fd, &action, 1, MSG_NOSIGNAL) < 0) {
+              // Der Server hat schon geschlossen, das OVER kommt noch.
+            }
+          }
+        }
+        continue;
+      }
+      Client &client = clients[index];
+      ssize_t length = read(client.fd, buffer, sizeof(buffer));
+      if (length > 0) {
+        client.in.append(buffer, length);
+        parseLines(client);
+      } else if (length == 0 || errno != EINTR) {
+        close(client.fd);
+        client.fd = -1;
+        open--;
+      }
+    }
+  }
+
+  int finished = 0;
+  int64_t lines = 0;
+  int64_t pieces = 0;
+  int winners = 0;
+  for (Client &client : clients) {
+    finished += client.place != 0;
+    winners += client.place == 1;
+    lines += client.lines;
+    pieces += client.pieces;
+    if (client.fd >= 0) {
+      close(client.fd);
+    }
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  std::cout << "Clients:  " << numClients << " (" << finished << " finished, "
+            << winners << " won)" << std::endl;
+  std::cout << "Pieces:   " << pieces << std::endl;
+  std::cout << "Lines:    " << lines << std::endl;
+  std::cout << "Time:     " << seconds << " s" << std::endl;
+  return finished == numClients ? 0 : 1;
+}
@@ -0,0 +1,341 @@
+#include "VersusServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+// Liest ein Client so lange nichts, wird er getrennt, statt den Speicher des
+// Servers zu füllen.
+const size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+Action actionFromProtocol(char c) {
+  switch (c) {
+  case 'L':
+    return Action::Left;
+  case 'R':
+    return Action::Right;
+  case 'D':
+    return Action::SoftDrop;
+  case 'H':
+    return Action::HardDrop;
+  case 'C':
+    return Action::RotateClockwise;
+  case 'A':
+    return Action::RotateCounterClockwise;
+  }
+  return Action::None;
+}
+
+void throwSystemError(const char *what) {
+  throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+} // namespace
+
+VersusServer::VersusServer(const VersusServerOptions &options)
+    : options_(options), listenFd_(-1), epollFd_(-1), timerFd_(-1),
+      stopRequested_(false) {
+  if (options_.playersPerMatch < 1) {
+    throw std::runtime_error("Need at least one player per match");
+  }
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (options_.socketPath.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + options_.socketPath);
+  }
+  std::strcpy(address.sun_path, options_.socketPath.c_str());
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0) {
+    throwSystemError("socket");
+  }
+  unlink(options_.socketPath.c_str());
+  if (bind(listenFd_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listenFd_, SOMAXCONN) < 0) {
+    close(listenFd_);
+    throwSystemError(options_.socketPath.c_str());
+  }
+
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  itimerspec interval{};
+  interval.it_interval.tv_nsec = 1000000000 / FRAMES_PER_SECOND;
+  interval.it_value = interval.it_interval;
+  // Ohne Takt rückt kein Spiel vor, ein Fehler hier macht den Server also
+  // unbrauchbar.
+  if (epollFd_ < 0 || timerFd_ < 0 ||
+      timerfd_settime(timerFd_, 0, &interval, nullptr) < 0 ||
+      !watch(listenFd_, false, EPOLL_CTL_ADD) ||
+      !watch(timerFd_, false, EPOLL_CTL_ADD)) {
+    // Was schon offen ist, wieder schließen, ohne `errno` zu verlieren.
+    int error = errno;
+    for (int fd : {listenFd_, epollFd_, timerFd_}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    unlink(options_.socketPath.c_str());
+    errno = error;
+    throwSystemError("epoll/timerfd");
+  }
+}
+
+VersusServer::~VersusServer() {
+  for (auto &client : clients_) {
+    if (client) {
+      close(client->fd);
+    }
+  }
+  close(timerFd_);
+  close(epollFd_);
+  close(listenFd_);
+  unlink(options_.socketPath.c_str());
+}
+
+bool VersusServer::watch(int fd, bool write, int op) {
+  epoll_event event{};
+  event.events = EPOLLIN | (write ? EPOLLOUT : 0u);
+  event.data.fd = fd;
+  return epoll_ctl(epollFd_, op, fd, &event) == 0;
+}
+
+void VersusServer::run() {
+  epoll_event events[256];
+  while (!stopRequested_) {
+    // Mit Timeout, damit `stop` auch ohne Takt (z.B. im Test) wirkt.
+    int n = epoll_wait(epollFd_, events, 256, 100);
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+      if (fd == listenFd_) {
+        acceptClients();
+      } else if (fd == timerFd_) {
+        uint64_t expirations = 0;
+        if (read(timerFd_, &expirations, sizeof(expirations)) !=
+            sizeof(expirations)) {
+          continue;
+        }
+        // Wie `FrameClock`: höchstens eine Sekunde nachholen.
+        int ticks = std::min<uint64_t>(expirations, FRAMES_PER_SECOND);
+        stats_.lateTicks += expirations - 1;
+        for (int t = 0; t < ticks; t++) {
+          tick();
+        }
+        for (auto &client : clients_) {
+          if (client && !client->out.empty()) {
+            writeClient(*client);
+          }
+        }
+      } else if (fd < static_cast<int>(clients_.size()) && clients_[fd]) {
+        if (events[i].events & EPOLLOUT) {
+          writeClient(*clients_[fd]);
+        }
+        if (clients_[fd] &&
+            (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+          readClient(fd);
+        }
+      }
+    }
+  }
+}
+
+void VersusServer::acceptClients() {
+  for (;;) {
+    int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      break;
+    }
+    // Ohne epoll bekäme der Client nie eine Antwort.
+    if (!watch(fd, false, EPOLL_CTL_ADD)) {
+      close(fd);
+      continue;
+    }
+    if (fd >= static_cast<int>(clients_.size())) {
+      clients_.resize(fd + 1);
+    }
+    clients_[fd] = std::make_unique<Client>();
+    clients_[fd]->fd = fd;
+    lobby_.push_back(fd);
+    stats_.clientsConnected++;
+  }
+  startMatches();
+}
+
+void VersusServer::startMatches() {
+  const int numPlayers = options_.playersPerMatch;
+  while (static_cast<int>(lobby_.size()) >= numPlayers) {
+    int index;
+    if (!freeMatches_.empty()) {
+      index = freeMatches_.back();
+      freeMatches_.pop_back();
+    } else {
+      index = matches_.size();
+      matches_.emplace_back();
+    }
+    uint64_t seed = options_.firstSeed + stats_.matchesStarted;
+    Match &match = matches_[index];
+    match.match = std::make_unique<VersusMatch>(seed, numPlayers);
+    match.clients.assign(lobby_.begin(), lobby_.begin() + numPlayers);
+    lobby_.erase(lobby_.begin(), lobby_.begin() + numPlayers);
+    for (int player = 0; player < numPlayers; player++) {
+      Client &client = *clients_[match.clients[player]];
+      client.match = index;
+      client.player = player;
+      char line[64];
+      std::snprintf(line, sizeof(line), "START %llu %d %d\n",
+                    static_cast<unsigned long long>(seed), numPlayers, player);
+      client.out += line;
+      writeClient(client);
+    }
+    stats_.matchesStarted++;
+    stats_.activeMatches++;
+    stats_.activeBoards += numPlayers;
+  }
+}
+
+void VersusServer::readClient(int fd) {
+  char buffer[4096];
+  for (;;) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n > 0) {
+      Client &client = *clients_[fd];
+      if (client.match < 0) {
+        continue;
+      }
+      VersusMatch &match = *matches_[client.match].match;
+      for (ssize_t i = 0; i < n; i++) {
+        match.queueInput(client.player, actionFromProtocol(buffer[i]));
+      }
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && errno == EAGAIN) {
+      return;
+    } else {
+      // Verbindung geschlossen oder Fehler.
+      closeClient(fd);
+      return;
+    }
+  }
+}
+
+void VersusServer::writeClient(Client &client) {
+  while (!client.out.empty()) {
+    // MSG_NOSIGNAL: ein geschlossener Client soll kein SIGPIPE auslösen.
+    ssize_t n =
+        send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN || client.out.size() > MAX_PENDING_OUTPUT) {
+        if (errno == EAGAIN) {
+          stats_.clientsDropped++;
+        }
+        closeClient(client.fd);
+        return;
+      }
+      if (!client.waitingForWrite) {
+        watch(client.fd, true, EPOLL_CTL_MOD);
+        client.waitingForWrite = true;
+      }
+      return;
+    }
+    client.out.erase(0, n);
+  }
+  if (client.closing) {
+    closeClient(client.fd);
+  } else if (client.waitingForWrite) {
+    watch(client.fd, false, EPOLL_CTL_MOD);
+    client.waitingForWrite = false;
+  }
+}
+
+void VersusServer::closeClient(int fd) {
+  Client &client = *clients_[fd];
+  if (client.match >= 0) {
+    // Wer die Verbindung verliert, gibt auf. Die Gegner erfahren das beim
+    // nächsten Takt.
+    Match &match = matches_[client.match];
+    match.match->forfeit(client.player);
+    match.clients[client.player] = -1;
+  }
+  lobby_.erase(std::remove(lobby_.begin(), lobby_.end(), fd), lobby_.end());
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  clients_[fd].reset();
+}
+
+void VersusServer::tick() {
+  stats_.ticks++;
+  for (size_t index = 0; index < matches_.size(); index++) {
+    Match &match = matches_[index];
+    if (!match.match) {
+      continue;
+    }
+    match.match->tick();
+    for (int player = 0; player < match.match->numPlayers(); player++) {
+      int fd = match.clients[player];
+      if (fd >= 0 && !clients_[fd]->closing) {
+        reportPlayer(*clients_[fd], match.match->player(player));
+      }
+    }
+    if (match.match->isFinished()) {
+      // Alle Spieler haben ihr OVER bekommen, die Verbindungen werden nach
+      // dem Senden geschlossen.
+      for (int fd : match.clients) {
+        if (fd >= 0) {
+          clients_[fd]->match = -1;
+        }
+      }
+      stats_.activeBoards -= match.match->numPlayers();
+      stats_.activeMatches--;
+      stats_.matchesFinished++;
+      match.match.reset();
+      match.clients.clear();
+      freeMatches_.push_back(index);
+    }
+  }
+}
+
+void VersusServer::reportPlayer(Client &client, const VersusPlayer &player) {
+  const GameState &state = player.state;
+  char line[256];
+  bool fieldChanged = state.piecesPlaced != client.lastPieces ||
+                      player.pendingGarbage.size() != client.lastGarbage;
+  if (fieldChanged) {
+    int length = std::snprintf(
+        line, sizeof(line), "FIELD %lld %d %d %zu",
+        static_cast<long long>(state.frame), state.piecesPlaced,
+        state.totalLinesCleared, player.pendingGarbage.size());
+    for (Board::Row row : state.field.getRows()) {
+      length += std::snprintf(line + length, sizeof(line) - length, " %03x",
+                              static_cast<unsigned>(row));
+    }
+    client.out.append(line, length);
+    client.out += '\n';
+    client.lastPieces = state.piecesPlaced;
+    client.lastGarbage = player.pendingGarbage.size();
+  }
+  const Tetromino &piece = state.currentTetromino;
+  const Tetromino &last = client.lastPiece;
+  if (fieldChanged || piece.getPiece() != last.getPiece() ||
+      piece.getRotation() != last.getRotation() ||
+      piece.getPosition() != last.getPosition()) {
+    auto [row, col] = piece.getPosition();
+    int length = std::snprintf(line, sizeof(line), "PIECE %lld %d %d %d %d\n",
+                               static_cast<long long>(state.frame),
+                               piece.getPiece(), piece.getRotation(), row, col);
+    client.out.append(line, length);
+    client.lastPiece = piece;
+  }
+  if (player.place != 0) {
+    int length = std::snprintf(line, sizeof(line), "OVER %d\n", player.place);
+    client.out.append(line, length);
+    client.closing = true;
+  }
+}
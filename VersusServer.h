@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Versus.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Server für viele gleichzeitige Versus-Spiele in einem Prozess. Clients
+// verbinden sich über einen Unix-Socket und kommen in die Lobby, sobald genug
+// Spieler da sind, beginnt ein Spiel. Alle Verbindungen und ein gemeinsamer
+// Taktgeber (timerfd, 60 Frames pro Sekunde) laufen über ein epoll, alle
+// Spiele rücken im selben Takt einen Frame vor.
+//
+// Protokoll (Text, damit es sich auch mit `socat` ausprobieren lässt):
+//   Client an Server: ein Zeichen pro Eingabe, L/R = links/rechts,
+//     D = Soft Drop, H = Hard Drop, C/A = Drehen im/gegen den Uhrzeigersinn.
+//     Alles andere wird ignoriert. Eingaben gelten ab dem nächsten Frame.
+//   Server an Client, je eine Zeile:
+//     START <seed> <spieler> <index>       Das Spiel beginnt.
+//     PIECE <frame> <stein> <rotation> <zeile> <spalte>
+//                                          Der Stein hat sich bewegt.
+//     FIELD <frame> <steine> <zeilen> <müll> <20 Zeilen als Hex>
+//                                          Das Feld hat sich geändert.
+//     OVER <platz>                         Ausgeschieden bzw. gewonnen
+//                                          (Platz 1), danach wird die
+//                                          Verbindung geschlossen.
+
+struct VersusServerOptions {
+  std::string socketPath = "/tmp/tetris-versus.sock";
+  int playersPerMatch = 2;
+  // Spiel `i` benutzt den Seed `firstSeed + i`.
+  uint64_t firstSeed = 1;
+};
+
+struct VersusServerStats {
+  int64_t ticks = 0;
+  // Takte, die zu spät verarbeitet wurden (der timerfd war mehr als einmal
+  // abgelaufen).
+  int64_t lateTicks = 0;
+  int64_t matchesStarted = 0;
+  int64_t matchesFinished = 0;
+  int64_t clientsConnected = 0;
+  // Clients, die getrennt wurden, weil sie ihre Daten nicht abholen.
+  int64_t clientsDropped = 0;
+  int activeMatches = 0;
+  int activeBoards = 0;
+};
+
+class VersusServer {
+public:
+  // Legt den Socket an (eine alte Datei an `socketPath` wird ersetzt). Wirft
+  // bei Fehlern eine Exception.
+  explicit VersusServer(const VersusServerOptions &options);
+  ~VersusServer();
+  VersusServer(const VersusServer &) = delete;
+  VersusServer &operator=(const VersusServer &) = delete;
+
+  // Läuft, bis `stop` aufgerufen wird (auch aus einem anderen Thread oder
+  // einem Signal-Handler).
+  void run();
+  void stop() { stopRequested_ = true; }
+
+  const VersusServerStats &stats() const { return stats_; }
+
+private:
+  struct Client {
+    int fd = -1;
+    // Spiel und Spieler, -1 solange der Client in der Lobby wartet.
+    int match = -1;
+    int player = -1;
+    std::string out;
+    // Zuletzt gemeldeter Zustand, um nur Änderungen zu schicken.
+    Tetromino lastPiece{0};
+    int lastPieces = -1;
+    size_t lastGarbage = 0;
+    // Nach dem Senden der ausstehenden Daten schließen.
+    bool closing = false;
+    // Ob epoll auch auf EPOLLOUT wartet.
+    bool waitingForWrite = false;
+  };
+  struct Match {
+    std::unique_ptr<VersusMatch> match;
+    std::vector<int> clients;
+  };
+
+  void acceptClients();
+  void readClient(int fd);
+  void writeClient(Client &client);
+  void closeClient(int fd);
+  void startMatches();
+  void tick();
+  void reportPlayer(Client &client, const VersusPlayer &player);
+  // Meldet `fd` bei epoll an (`op`), gibt zurück, ob das geklappt hat.
+  bool watch(int fd, bool write, int op);
+
+  VersusServerOptions options_;
+  int listenFd_;
+  int epollFd_;
+  int timerFd_;
+  std::atomic<bool> stopRequested_;
+  // Clients nach Dateideskriptor.
+  std::vector<std::unique_ptr<Client>> clients_;
+  std::vector<int> lobby_;
+  std::vector<Match> matches_;
+  std::vector<int> freeMatches_;
+  VersusServerStats stats_;
+};
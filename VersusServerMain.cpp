@@ -0,0 +1,57 @@
+#include "./VersusServer.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+VersusServer *runningServer = nullptr;
+
+void handleSignal(int) {
+  if (runningServer != nullptr) {
+    runningServer->stop();
+  }
+}
+} // namespace
+
+// Startet den Versus-Server (siehe VersusServer.h) und läuft bis Ctrl+C.
+int main(int argc, char **argv) {
+  VersusServerOptions options;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--socket") == 0 && hasValue) {
+      options.socketPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--players") == 0 && hasValue) {
+      options.playersPerMatch = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      options.firstSeed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--socket PATH] [--players N] [--seed S]" << std::endl;
+      return 1;
+    }
+  }
+
+  try {
+    VersusServer server(options);
+    runningServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::cout << "Listening on " << options.socketPath << ", "
+              << options.playersPerMatch << " players per match" << std::endl;
+    server.run();
+    runningServer = nullptr;
+
+    const VersusServerStats &stats = server.stats();
+    std::cout << "Ticks:          " << stats.ticks << " (" << stats.lateTicks
+              << " late)" << std::endl;
+    std::cout << "Clients:        " << stats.clientsConnected << " ("
+              << stats.clientsDropped << " dropped)" << std::endl;
+    std::cout << "Matches:        " << stats.matchesStarted << " started, "
+              << stats.matchesFinished << " finished" << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}